@@ -54,6 +54,8 @@ void alarm_context_init(alarm_context_t *context, const char *name)
 
     context->num_pending_alarms = 0;
     context->next_pending_alarm_clk = (CLOCK) ~0L;
+    context->next_pending_alarm_idx = -1;
+    context->next_seq = 0;
 }
 
 void alarm_context_destroy(alarm_context_t *context)
@@ -167,7 +169,7 @@ void alarm_destroy(alarm_t *alarm)
 void alarm_unset(alarm_t *alarm)
 {
     alarm_context_t *context;
-    int idx;
+    int idx, last;
 
     idx = alarm->pending_idx;
 
@@ -176,33 +178,24 @@ void alarm_unset(alarm_t *alarm)
     }
     context = alarm->context;
 
-    if (context->num_pending_alarms > 1) {
-        int last;
+    last = (int)(--context->num_pending_alarms);
 
-        last = --context->num_pending_alarms;
+    if (last != idx) {
+        pending_alarms_t old = context->pending_alarms[idx];
 
-        if (last != idx) {
-            /* Let's copy the struct by hand to make sure stupid compilers
-               don't do stupid things.  */
-            context->pending_alarms[idx].alarm
-                = context->pending_alarms[last].alarm;
-            context->pending_alarms[idx].clk
-                = context->pending_alarms[last].clk;
+        /* Move the last heap entry into the hole and restore the heap
+           property.  */
+        context->pending_alarms[idx] = context->pending_alarms[last];
 
-            context->pending_alarms[idx].alarm->pending_idx = idx;
-        }
-
-        if (context->next_pending_alarm_idx == idx) {
-            alarm_context_update_next_pending(context);
-        } else if (context->next_pending_alarm_idx == last) {
-            context->next_pending_alarm_idx = idx;
+        if (alarm_pending_before(&context->pending_alarms[idx], &old)) {
+            alarm_context_sift_up(context, idx);
+        } else {
+            alarm_context_sift_down(context, idx);
         }
-    } else {
-        context->num_pending_alarms = 0;
-        context->next_pending_alarm_clk = (CLOCK) ~0L;
-        context->next_pending_alarm_idx = -1;
     }
 
+    alarm_context_update_next_pending(context);
+
     alarm->pending_idx = -1;
 }
 
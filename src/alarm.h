@@ -63,6 +63,9 @@ struct pending_alarms_s {
 
     /* Clock tick at which this alarm should be activated.  */
     CLOCK clk;
+
+    /* Order in which the alarm was set, breaks ties on `clk'.  */
+    unsigned int seq;
 };
 typedef struct pending_alarms_s pending_alarms_t;
 
@@ -74,15 +77,18 @@ struct alarm_context_s {
     /* Alarm list.  */
     struct alarm_s *alarms;
 
-    /* Pending alarm array.  Statically allocated because it's slightly
-       faster this way.  */
+    /* Pending alarm array, kept as a binary min-heap on `clk' and `seq'.
+       Statically allocated because it's slightly faster this way.  */
     pending_alarms_t pending_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
     unsigned int num_pending_alarms;
 
+    /* Sequence number for the next alarm_set().  */
+    unsigned int next_seq;
+
     /* Clock tick for the next pending alarm.  */
     CLOCK next_pending_alarm_clk;
 
-    /* Pending alarm number.  */
+    /* Pending alarm number, 0 (the heap root) or -1 if none.  */
     int next_pending_alarm_idx;
 };
 typedef struct alarm_context_s alarm_context_t;
@@ -109,25 +115,79 @@ inline static CLOCK alarm_context_next_pending_clk(alarm_context_t *context)
     return context->next_pending_alarm_clk;
 }
 
-inline static void alarm_context_update_next_pending(alarm_context_t *context)
+/* The pending alarms are kept as a binary min-heap ordered by clock, so
+   the next alarm to dispatch is always `pending_alarms[0]' and setting or
+   unsetting an alarm costs O(log n) instead of a scan of the whole array.
+   Alarms due on the same clock are dispatched in the order they were set.
+   `alarm->pending_idx' always tracks the heap slot of the alarm.  */
+
+inline static int alarm_pending_before(const pending_alarms_t *a,
+                                       const pending_alarms_t *b)
 {
-    CLOCK next_pending_alarm_clk = (CLOCK)~0L;
-    int next_pending_alarm_idx;
-    unsigned int i;
+    if (a->clk != b->clk) {
+        return a->clk < b->clk;
+    }
+    return (int)(a->seq - b->seq) < 0;
+}
+
+inline static void alarm_context_sift_up(alarm_context_t *context, int idx)
+{
+    pending_alarms_t *pending_alarms = context->pending_alarms;
+    pending_alarms_t entry = pending_alarms[idx];
+
+    while (idx > 0) {
+        int parent = (idx - 1) >> 1;
+
+        if (!alarm_pending_before(&entry, &pending_alarms[parent])) {
+            break;
+        }
+        pending_alarms[idx] = pending_alarms[parent];
+        pending_alarms[idx].alarm->pending_idx = idx;
+        idx = parent;
+    }
+
+    pending_alarms[idx] = entry;
+    entry.alarm->pending_idx = idx;
+}
 
-    next_pending_alarm_idx = context->next_pending_alarm_idx;
+inline static void alarm_context_sift_down(alarm_context_t *context, int idx)
+{
+    pending_alarms_t *pending_alarms = context->pending_alarms;
+    int num = (int)(context->num_pending_alarms);
+    pending_alarms_t entry = pending_alarms[idx];
 
-    for (i = 0; i < context->num_pending_alarms; i++) {
-        CLOCK pending_clk = context->pending_alarms[i].clk;
+    for (;;) {
+        int child = (idx << 1) + 1;
 
-        if (pending_clk <= next_pending_alarm_clk) {
-            next_pending_alarm_clk = pending_clk;
-            next_pending_alarm_idx = (int)i;
+        if (child >= num) {
+            break;
+        }
+        if (child + 1 < num
+            && alarm_pending_before(&pending_alarms[child + 1],
+                                    &pending_alarms[child])) {
+            child++;
+        }
+        if (!alarm_pending_before(&pending_alarms[child], &entry)) {
+            break;
         }
+        pending_alarms[idx] = pending_alarms[child];
+        pending_alarms[idx].alarm->pending_idx = idx;
+        idx = child;
     }
 
-    context->next_pending_alarm_clk = next_pending_alarm_clk;
-    context->next_pending_alarm_idx = next_pending_alarm_idx;
+    pending_alarms[idx] = entry;
+    entry.alarm->pending_idx = idx;
+}
+
+inline static void alarm_context_update_next_pending(alarm_context_t *context)
+{
+    if (context->num_pending_alarms > 0) {
+        context->next_pending_alarm_clk = context->pending_alarms[0].clk;
+        context->next_pending_alarm_idx = 0;
+    } else {
+        context->next_pending_alarm_clk = (CLOCK)~0L;
+        context->next_pending_alarm_idx = -1;
+    }
 }
 
 inline static void alarm_context_dispatch(alarm_context_t *context,
@@ -166,24 +226,22 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
 
         context->pending_alarms[new_idx].alarm = alarm;
         context->pending_alarms[new_idx].clk = cpu_clk;
+        context->pending_alarms[new_idx].seq = context->next_seq++;
 
         context->num_pending_alarms++;
 
-        if (cpu_clk < context->next_pending_alarm_clk) {
-            context->next_pending_alarm_clk = cpu_clk;
-            context->next_pending_alarm_idx = new_idx;
-        }
-
-        alarm->pending_idx = new_idx;
+        alarm_context_sift_up(context, new_idx);
     } else {
-        /* Already pending: modify.  */
+        /* Already pending: modify.  The new key is always later than the
+           old one on ties, so the entry may have to move either way.  */
 
         context->pending_alarms[idx].clk = cpu_clk;
-        if (context->next_pending_alarm_clk > cpu_clk
-            || idx == context->next_pending_alarm_idx) {
-            alarm_context_update_next_pending(context);
-        }
+        context->pending_alarms[idx].seq = context->next_seq++;
+        alarm_context_sift_up(context, idx);
+        alarm_context_sift_down(context, alarm->pending_idx);
     }
+
+    alarm_context_update_next_pending(context);
 }
 
 #endif
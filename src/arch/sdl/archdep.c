@@ -55,6 +55,7 @@ static void archdep_shutdown_extra(void);
 #endif
 
 #include "kbd.h"
+#include "machine.h"
 
 #ifndef SDL_REALINIT
 #define SDL_REALINIT SDL_Init
@@ -62,7 +63,8 @@ static void archdep_shutdown_extra(void);
 
 int archdep_init(int *argc, char **argv)
 {
-    if (SDL_REALINIT(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
+    /* headless runs never open a window, only the timer is needed */
+    if (SDL_REALINIT(headless_mode ? SDL_INIT_TIMER : (SDL_INIT_VIDEO | SDL_INIT_TIMER)) < 0) {
         fprintf(stderr, "SDL error: %s\n", SDL_GetError());
         return 1;
     }
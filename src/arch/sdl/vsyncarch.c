@@ -103,6 +103,12 @@ void vsyncarch_sleep(unsigned long delay)
 
 void vsyncarch_presync(void)
 {
+    if (headless_mode) {
+        /* no UI to poll, only feed the keyboard buffer (autostart) */
+        kbdbuf_flush();
+        return;
+    }
+
     if (sdl_vkbd_state & SDL_VKBD_ACTIVE) {
         while (sdl_vkbd_process(ui_dispatch_events())) {
         }
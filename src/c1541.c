@@ -175,6 +175,9 @@ const char *machine_get_name(void);
 const char machine_name[] = "C1541";
 int machine_class = VICE_MACHINE_C1541;
 
+/* read by the SDL archdep_init(), the tools never run headless */
+int headless_mode = 0;
+
 /* Global clock counter.  */
 CLOCK clk = 0L;
 
@@ -27,6 +27,11 @@
 #ifndef VICE_C64_SNAPSHOT_H
 #define VICE_C64_SNAPSHOT_H
 
+#include "types.h"
+
+
 extern int c64_snapshot_write(const char *name, int save_roms, int save_disks, int event_mode);
 extern int c64_snapshot_read(const char *name, int event_mode);
+extern int c64_snapshot_write_mem(uint8_t **data_return, size_t *size_return, int save_roms, int save_disks, int event_mode);
+extern int c64_snapshot_read_mem(const uint8_t *data, size_t size, int event_mode);
 #endif
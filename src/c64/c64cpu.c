@@ -25,6 +25,7 @@
 
 #include "vice.h"
 
+#include "c64mem.h"
 #include "maincpu.h"
 #include "mem.h"
 
@@ -116,6 +117,34 @@ static void memmap_mark_read(unsigned int addr)
 }
 #endif
 
+#ifndef FEATURE_CPUMEMHISTORY
+/* Data accesses to plain RAM are done directly, everything else goes
+   through the read/store functions.  */
+inline static uint8_t c64_mem_load(unsigned int addr)
+{
+    uint8_t *p = _mem_read_ram_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        return p[(uint16_t)addr];
+    }
+    return (*_mem_read_tab_ptr[addr >> 8])((uint16_t)addr);
+}
+
+inline static void c64_mem_store(unsigned int addr, uint8_t value)
+{
+    uint8_t *p = _mem_write_ram_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        p[(uint16_t)addr] = value;
+    } else {
+        (*_mem_write_tab_ptr[addr >> 8])((uint16_t)addr, value);
+    }
+}
+
+#define LOAD(addr) c64_mem_load((unsigned int)(addr))
+#define STORE(addr, value) c64_mem_store((unsigned int)(addr), (uint8_t)(value))
+#endif
+
 static void check_and_run_alternate_cpu(void)
 {
     cpmcart_check_and_run_z80();
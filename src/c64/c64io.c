@@ -77,6 +77,82 @@ static io_source_list_t c64io_d700_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_de00_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_df00_head = { NULL, NULL, NULL };
 
+static struct {
+    io_source_list_t *head;
+    unsigned int page;
+} c64io_pages[] = {
+    { &c64io_d000_head, 0xd000 },
+    { &c64io_d100_head, 0xd100 },
+    { &c64io_d200_head, 0xd200 },
+    { &c64io_d300_head, 0xd300 },
+    { &c64io_d400_head, 0xd400 },
+    { &c64io_d500_head, 0xd500 },
+    { &c64io_d600_head, 0xd600 },
+    { &c64io_d700_head, 0xd700 },
+    { &c64io_de00_head, 0xde00 },
+    { &c64io_df00_head, 0xdf00 },
+    { NULL, 0 }
+};
+
+/* Per-address dispatch table, indexed by bits 8-11 and 0-7 of the address.
+   An entry points to the device when exactly one registered device covers
+   that address, otherwise it is NULL and the list is walked so collisions
+   are detected the usual way.  Rebuilt on every (un)register.  */
+static io_source_t *c64io_single[0x10][0x100];
+
+static void io_source_table_rebuild(void)
+{
+    io_source_list_t *current;
+    uint8_t count[0x100];
+    unsigned int addr, start, end, page;
+    int i;
+
+    memset(c64io_single, 0, sizeof(c64io_single));
+
+    for (i = 0; c64io_pages[i].head != NULL; i++) {
+        memset(count, 0, sizeof(count));
+        current = c64io_pages[i].head->next;
+        page = c64io_pages[i].page;
+
+        while (current) {
+            start = current->device->start_address;
+            end = current->device->end_address;
+            if (start < page) {
+                start = page;
+            }
+            if (end > page + 0xff) {
+                end = page + 0xff;
+            }
+            for (addr = start; addr <= end; addr++) {
+                if (count[addr & 0xff] < 2) {
+                    count[addr & 0xff]++;
+                }
+                c64io_single[(page >> 8) & 0x0f][addr & 0xff] = current->device;
+            }
+            current = current->next;
+        }
+
+        for (addr = 0; addr < 0x100; addr++) {
+            if (count[addr] != 1) {
+                c64io_single[(page >> 8) & 0x0f][addr] = NULL;
+            }
+        }
+    }
+}
+
+/* Return the only device covering `addr', or NULL if there are none or
+   several.  The range check catches devices that were moved without being
+   re-registered.  */
+static inline io_source_t *io_source_single(uint16_t addr)
+{
+    io_source_t *device = c64io_single[(addr >> 8) & 0x0f][addr & 0xff];
+
+    if (device != NULL && addr >= device->start_address && addr <= device->end_address) {
+        return device;
+    }
+    return NULL;
+}
+
 static void io_source_detach(io_source_detach_t *source)
 {
     switch (source->det_id) {
@@ -301,9 +377,22 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
     uint8_t retval = 0;
     uint8_t firstval = 0;
     unsigned int lowest_order = 0xffffffff;
+    io_source_t *device;
 
     vicii_handle_pending_alarms_external(0);
 
+    /* fast path, only one device at this address so no collision is possible */
+    device = io_source_single(addr);
+    if (device != NULL) {
+        if (device->read != NULL) {
+            retval = device->read((uint16_t)(addr & device->address_mask));
+            if (device->io_source_valid) {
+                return retval;
+            }
+        }
+        return vicii_read_phi1();
+    }
+
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
@@ -375,6 +464,16 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
 static inline uint8_t io_peek(io_source_list_t *list, uint16_t addr)
 {
     io_source_list_t *current = list->next;
+    io_source_t *device = io_source_single(addr);
+
+    if (device != NULL) {
+        if (device->peek) {
+            return device->peek((uint16_t)(addr & device->address_mask));
+        } else if (device->read) {
+            return device->read((uint16_t)(addr & device->address_mask));
+        }
+        return vicii_read_phi1();
+    }
 
     while (current) {
         if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -396,9 +495,19 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
     uint16_t addy = 0xffff;
     io_source_list_t *current = list->next;
     void (*store)(uint16_t address, uint8_t data) = NULL;
+    io_source_t *device;
 
     vicii_handle_pending_alarms_external_write();
 
+    /* fast path, a single device gets the write whatever its priority */
+    device = io_source_single(addr);
+    if (device != NULL) {
+        if (device->store != NULL) {
+            device->store((uint16_t)(addr & device->address_mask), value);
+        }
+        return;
+    }
+
     while (current) {
         if (current->device->store != NULL) {
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -472,6 +581,8 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->next = NULL;
     retval->device->order = order++;
 
+    io_source_table_rebuild();
+
     return retval;
 }
 
@@ -496,6 +607,8 @@ void io_source_unregister(io_source_list_t *device)
     }
 
     lib_free(device);
+
+    io_source_table_rebuild();
 }
 
 void cartio_shutdown(void)
@@ -99,6 +99,10 @@ store_func_ptr_t *_mem_write_tab_ptr;
 static uint8_t **_mem_read_base_tab_ptr;
 static uint32_t *mem_read_limit_tab_ptr;
 
+/* Pointers to the currently used plain RAM tables.  */
+uint8_t **_mem_read_ram_tab_ptr;
+uint8_t **_mem_write_ram_tab_ptr;
+
 /* Memory read and write tables.  */
 static store_func_ptr_t mem_write_tab[NUM_VBANKS][NUM_CONFIGS][0x101];
 static read_func_ptr_t mem_read_tab[NUM_CONFIGS][0x101];
@@ -108,6 +112,16 @@ static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+/* Plain RAM tables: `mem_ram' for pages that are handled by `ram_read()'
+   and `ram_store()', NULL for everything else (I/O, ROM, cartridges,
+   RAM expansions...).  These let the CPU access ordinary RAM without
+   going through the function pointers.  */
+static uint8_t *mem_write_ram_tab[NUM_VBANKS][NUM_CONFIGS][0x101];
+static uint8_t *mem_read_ram_tab[NUM_CONFIGS][0x101];
+
+/* All NULL, used while watchpoints are active.  */
+static uint8_t *mem_ram_tab_watch[0x101];
+
 /* Current video bank (0, 1, 2 or 3).  */
 static int vbank;
 
@@ -156,9 +170,13 @@ void mem_toggle_watchpoints(int flag, void *context)
     if (flag) {
         _mem_read_tab_ptr = mem_read_tab_watch;
         _mem_write_tab_ptr = mem_write_tab_watch;
+        _mem_read_ram_tab_ptr = mem_ram_tab_watch;
+        _mem_write_ram_tab_ptr = mem_ram_tab_watch;
     } else {
         _mem_read_tab_ptr = mem_read_tab[mem_config];
         _mem_write_tab_ptr = mem_write_tab[vbank][mem_config];
+        _mem_read_ram_tab_ptr = mem_read_ram_tab[mem_config];
+        _mem_write_ram_tab_ptr = mem_write_ram_tab[vbank][mem_config];
     }
     watchpoints_active = flag;
 }
@@ -203,6 +221,9 @@ static void clk_overflow_callback(CLOCK sub, void *unused_data)
 void c64_mem_init(void)
 {
     clk_guard_add_callback(maincpu_clk_guard, clk_overflow_callback, NULL);
+
+    /* Let the REU do block transfers on plain RAM pages.  */
+    reu_host_ram_register(&_mem_read_ram_tab_ptr, &_mem_write_ram_tab_ptr);
 }
 
 void mem_pla_config_changed(void)
@@ -214,9 +235,13 @@ void mem_pla_config_changed(void)
     if (watchpoints_active) {
         _mem_read_tab_ptr = mem_read_tab_watch;
         _mem_write_tab_ptr = mem_write_tab_watch;
+        _mem_read_ram_tab_ptr = mem_ram_tab_watch;
+        _mem_write_ram_tab_ptr = mem_ram_tab_watch;
     } else {
         _mem_read_tab_ptr = mem_read_tab[mem_config];
         _mem_write_tab_ptr = mem_write_tab[vbank][mem_config];
+        _mem_read_ram_tab_ptr = mem_read_ram_tab[mem_config];
+        _mem_write_ram_tab_ptr = mem_write_ram_tab[vbank][mem_config];
     }
 
     _mem_read_base_tab_ptr = mem_read_base_tab[mem_config];
@@ -643,6 +668,21 @@ static void plus60k_init_config(void)
     }
 }
 
+/* Derive the plain RAM tables from the final read/write tables.  */
+static void mem_ram_tab_init(void)
+{
+    int i, j, k;
+
+    for (i = 0; i < NUM_CONFIGS; i++) {
+        for (j = 0; j <= 0x100; j++) {
+            mem_read_ram_tab[i][j] = (mem_read_tab[i][j] == ram_read) ? mem_ram : NULL;
+            for (k = 0; k < NUM_VBANKS; k++) {
+                mem_write_ram_tab[k][i][j] = (mem_write_tab[k][i][j] == ram_store) ? mem_ram : NULL;
+            }
+        }
+    }
+}
+
 /* ------------------------------------------------------------------------- */
 
 void mem_set_write_hook(int config, int page, store_func_t *f)
@@ -783,6 +823,8 @@ void mem_initialize_memory(void)
     if (board == 1) {
         mem_limit_max_init(mem_read_limit_tab);
     }
+
+    mem_ram_tab_init();
 }
 
 void mem_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
@@ -820,6 +862,7 @@ void mem_set_vbank(int new_vbank)
     /* Do not override watchpoints on vbank switches.  */
     if (_mem_write_tab_ptr != mem_write_tab_watch) {
         _mem_write_tab_ptr = mem_write_tab[new_vbank][mem_config];
+        _mem_write_ram_tab_ptr = mem_write_ram_tab[new_vbank][mem_config];
     }
 
     vicii_set_vbank(new_vbank);
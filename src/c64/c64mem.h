@@ -79,6 +79,11 @@ extern void mem_set_tape_motor_in(int val);
 
 extern uint8_t mem_chargen_rom[C64_CHARGEN_ROM_SIZE];
 
+/* Plain RAM pages of the current configuration, NULL where the access has
+   to go through `_mem_read_tab_ptr' or `_mem_write_tab_ptr'.  */
+extern uint8_t **_mem_read_ram_tab_ptr;
+extern uint8_t **_mem_write_ram_tab_ptr;
+
 extern void mem_set_write_hook(int config, int page, store_func_t *f);
 extern void mem_read_tab_set(unsigned int base, unsigned int index, read_func_ptr_t read_func);
 extern void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr);
@@ -529,6 +529,27 @@ int cartridge_type_enabled(int type)
     return cart_type_enabled(type);
 }
 
+/*
+    size of the temporary array for attaching an image: ROMs are at most
+    C64CART_ROM_LIMIT, RAM expansion images can be as large as the file.
+*/
+static size_t cart_image_buffer_size(const char *filename)
+{
+    size_t size = C64CART_ROM_LIMIT;
+    size_t len;
+    FILE *fd;
+
+    fd = fopen(filename, MODE_READ);
+    if (fd != NULL) {
+        len = util_file_length(fd);
+        fclose(fd);
+        if (len > size) {
+            size = (len < C64CART_IMAGE_LIMIT) ? len : C64CART_IMAGE_LIMIT;
+        }
+    }
+    return size;
+}
+
 /*
     attach cartridge image
 
@@ -540,6 +561,7 @@ int cartridge_type_enabled(int type)
 int cartridge_attach_image(int type, const char *filename)
 {
     uint8_t *rawcart;
+    size_t rawcart_size;
     char *abs_filename;
     int carttype = CARTRIDGE_NONE;
     int cartid = CARTRIDGE_NONE;
@@ -574,7 +596,8 @@ int cartridge_attach_image(int type, const char *filename)
     DBG(("CART: cartridge_attach_image type: %d ID: %d\n", type, carttype));
 
     /* allocate temporary array */
-    rawcart = lib_malloc(C64CART_IMAGE_LIMIT);
+    rawcart_size = cart_image_buffer_size(abs_filename);
+    rawcart = lib_malloc(rawcart_size);
 
 /*  cart should always be detached. there is no reason for doing fancy checks
     here, and it will cause problems incase a cart MUST be detached before
@@ -600,7 +623,7 @@ int cartridge_attach_image(int type, const char *filename)
 
     if (type == CARTRIDGE_CRT) {
         DBG(("CART: attach CRT ID: %d '%s'\n", carttype, filename));
-        cartid = crt_attach(abs_filename, rawcart);
+        cartid = crt_attach(abs_filename, rawcart, rawcart_size);
         if (cartid == CARTRIDGE_NONE) {
             goto exiterror;
         }
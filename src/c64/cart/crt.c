@@ -30,10 +30,22 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef WIN32_COMPILE
+#include <io.h>
+#elif defined(HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+
+#include "alarm.h"
 #include "archdep.h"
 #include "cartridge.h"
 #include "crt.h"
+#include "flash040.h"
+#include "ioutil.h"
+#include "lib.h"
 #include "log.h"
+#include "machine.h"
+#include "maincpu.h"
 #include "resources.h"
 #include "types.h"
 #include "c64cart.h"
@@ -116,6 +128,10 @@
  */
 const char CRT_HEADER[] = "C64 CARTRIDGE   ";
 static const char CHIP_HEADER[] = "CHIP";
+static const char JOURNAL_HEADER[] = "VICE CRT JOURNAL";
+
+/* size of the rawcart array of the running crt_attach() */
+static size_t crt_rawcart_size = C64CART_IMAGE_LIMIT;
 
 /*
     Open a crt file and read header, return NULL on fault, fd otherwise
@@ -167,6 +183,284 @@ static FILE *crt_open(const char *filename, crt_header_t *header)
     fclose(fd);
     return NULL; /* Fault */
 }
+/* Flush `fd' and make sure the data is on the disk.  */
+static int crt_sync_file(FILE *fd)
+{
+    if (fflush(fd) != 0) {
+        return -1;
+    }
+#ifdef WIN32_COMPILE
+    return _commit(fileno(fd));
+#elif defined(HAVE_UNISTD_H)
+    return fsync(fileno(fd));
+#else
+    return 0;
+#endif
+}
+
+/*
+    Write chunks back into an existing (crt or bin) image file.
+
+    The chunks are first written completely to "<filename>.journal", which
+    is removed once the image itself is updated.  If the emulator dies in
+    between, crt_journal_replay() finishes the job on the next attach, so
+    the image never stays half updated.  Return -1 on fault.
+
+    The journal is the header, followed by records of a 4 byte offset, a 4
+    byte size and the data, terminated by a record with size 0.
+*/
+int crt_journal_write(const char *filename, const crt_chunk_t *chunks, int num)
+{
+    uint8_t record[8];
+    char *journal;
+    FILE *fd;
+    int i, rc = -1;
+
+    if (filename == NULL) {
+        return -1;
+    }
+    if (num == 0) {
+        return 0;
+    }
+
+    journal = util_concat(filename, ".journal", NULL);
+
+    fd = fopen(journal, MODE_WRITE);
+    if (fd == NULL) {
+        goto out;
+    }
+    if (fwrite(JOURNAL_HEADER, 16, 1, fd) < 1) {
+        goto fail_journal;
+    }
+    for (i = 0; i < num; i++) {
+        util_dword_to_be_buf(&record[0], (uint32_t)chunks[i].offset);
+        util_dword_to_be_buf(&record[4], chunks[i].size);
+        if ((fwrite(record, sizeof(record), 1, fd) < 1)
+            || (fwrite(chunks[i].data, chunks[i].size, 1, fd) < 1)) {
+            goto fail_journal;
+        }
+    }
+    memset(record, 0, sizeof(record));
+    if ((fwrite(record, sizeof(record), 1, fd) < 1) || crt_sync_file(fd) != 0) {
+        goto fail_journal;
+    }
+    fclose(fd);
+
+    /* the journal is complete, now update the image itself */
+    fd = fopen(filename, MODE_READ_WRITE);
+    if (fd == NULL) {
+        ioutil_remove(journal);
+        goto out;
+    }
+    for (i = 0; i < num; i++) {
+        if ((fseek(fd, chunks[i].offset, SEEK_SET) != 0)
+            || (fwrite(chunks[i].data, chunks[i].size, 1, fd) < 1)) {
+            fclose(fd);
+            goto out;
+        }
+    }
+    /* the journal must not go away before the image is on the disk */
+    if (crt_sync_file(fd) != 0) {
+        fclose(fd);
+        goto out;
+    }
+    if (fclose(fd) == 0) {
+        ioutil_remove(journal);
+        rc = 0;
+    }
+    goto out;
+
+fail_journal:
+    /* the image was not touched yet, an incomplete journal is useless */
+    fclose(fd);
+    ioutil_remove(journal);
+out:
+    if (rc < 0) {
+        log_error(LOG_DEFAULT, "CRT: could not write back to '%s'.", filename);
+    }
+    lib_free(journal);
+    return rc;
+}
+
+/*
+    Apply a complete journal left over from crt_journal_write() to the image,
+    and remove it.  Return -1 on fault, 0 otherwise (also when no journal
+    exists).
+*/
+int crt_journal_replay(const char *filename)
+{
+    uint8_t header[16], record[8];
+    uint8_t *data = NULL;
+    uint32_t offset, size;
+    char *journal;
+    FILE *fd, *image = NULL;
+    int pass, rc = -1;
+
+    if (filename == NULL) {
+        return 0;
+    }
+
+    journal = util_concat(filename, ".journal", NULL);
+
+    fd = fopen(journal, MODE_READ);
+    if (fd == NULL) {
+        lib_free(journal);
+        return 0;
+    }
+
+    /* first check that the journal is complete, then apply it */
+    for (pass = 0; pass < 2; pass++) {
+        if ((fseek(fd, 0, SEEK_SET) != 0)
+            || (fread(header, sizeof(header), 1, fd) < 1)
+            || memcmp(header, JOURNAL_HEADER, sizeof(header))) {
+            goto incomplete;
+        }
+        while (1) {
+            if (fread(record, sizeof(record), 1, fd) < 1) {
+                goto incomplete;
+            }
+            offset = util_be_buf_to_dword(&record[0]);
+            size = util_be_buf_to_dword(&record[4]);
+            if (size == 0) {
+                break;
+            }
+            if (size > C64CART_IMAGE_LIMIT) {
+                goto incomplete;
+            }
+            data = lib_realloc(data, size);
+            if (fread(data, size, 1, fd) < 1) {
+                goto incomplete;
+            }
+            if (pass == 1) {
+                if ((fseek(image, (long)offset, SEEK_SET) != 0)
+                    || (fwrite(data, size, 1, image) < 1)) {
+                    goto fail;
+                }
+            }
+        }
+        if (pass == 0) {
+            image = fopen(filename, MODE_READ_WRITE);
+            if (image == NULL) {
+                goto fail;
+            }
+        }
+    }
+    /* the image must be on disk before the journal goes away */
+    if (crt_sync_file(image) != 0) {
+        goto fail;
+    }
+    if (fclose(image) != 0) {
+        image = NULL;
+        goto fail;
+    }
+    image = NULL;
+    log_message(LOG_DEFAULT, "CRT: finished interrupted write back to '%s'.", filename);
+
+incomplete:
+    /* the image is still open only if reading failed while applying the
+       journal, part of it may be written already so keep the journal */
+    if (image != NULL) {
+        goto fail;
+    }
+    /* an incomplete journal means the image was never touched */
+    rc = 0;
+    fclose(fd);
+    fd = NULL;
+    ioutil_remove(journal);
+fail:
+    if (rc < 0) {
+        log_error(LOG_DEFAULT, "CRT: could not apply '%s'.", journal);
+    }
+    if (image != NULL) {
+        fclose(image);
+    }
+    if (fd != NULL) {
+        fclose(fd);
+    }
+    lib_free(data);
+    lib_free(journal);
+    return rc;
+}
+
+/*
+    Helpers for the flash carts that write changed chips back into the
+    attached image.  Each keeps the file offset of every 8k chip, -1 for the
+    chips that are not in the file.
+*/
+
+/* Set `num' chip offsets, the chips from `first' on are `step' bytes apart
+   starting at `start', the ones before are not in the file.  */
+void crt_set_chip_offsets(long *offset, int num, int first, long start, long step)
+{
+    int i;
+
+    for (i = 0; i < num; i++) {
+        offset[i] = (i < first) ? -1 : start + (i - first) * step;
+    }
+}
+
+/* Saving over the attached image moves its chips, so the offsets have to
+   be updated when this returns true.  */
+int crt_is_attached_image(const char *attached, const char *filename)
+{
+    return (attached != NULL) && (strcmp(filename, attached) == 0);
+}
+
+/*
+    Write the 8k chips of the `num_flash' flash chips in `flash' that were
+    changed since the last write back into the image in place.  `offset'
+    holds `num_chips' offsets per flash chip.  Returns 1 if a changed chip is
+    not in the file and not empty, so the image has to be saved as a whole,
+    -1 on fault.
+*/
+int crt_flash_write_dirty(const char *filename, flash040_context_t **flash,
+                          int num_flash, const long *offset, int num_chips)
+{
+    crt_chunk_t *chunks;
+    uint8_t *data;
+    int i, j, k, num = 0, rc;
+
+    chunks = lib_malloc(num_flash * num_chips * sizeof(crt_chunk_t));
+
+    for (i = 0; i < num_flash; i++) {
+        for (j = 0; j < num_chips; j++, offset++) {
+            if (!flash040core_range_dirty(flash[i], j * 0x2000, 0x2000)) {
+                continue;
+            }
+            data = flash[i]->flash_data + j * 0x2000;
+            if (*offset < 0) {
+                for (k = 0; k < 0x2000; k++) {
+                    if (data[k] != 0xff) {
+                        lib_free(chunks);
+                        return 1;
+                    }
+                }
+                continue; /* still loads as empty flash */
+            }
+            chunks[num].offset = *offset;
+            chunks[num].data = data;
+            chunks[num].size = 0x2000;
+            num++;
+        }
+    }
+    rc = crt_journal_write(filename, chunks, num);
+    lib_free(chunks);
+    return rc;
+}
+
+/* (Re)start the alarm for writing the image back every `interval' seconds,
+   0 stops it.  */
+void crt_write_alarm_set(alarm_t *alarm, int interval)
+{
+    if (alarm == NULL) {
+        return;
+    }
+    alarm_unset(alarm);
+    if (interval > 0) {
+        alarm_set(alarm, maincpu_clk + (CLOCK)interval * machine_get_cycles_per_second());
+    }
+}
+
 /*
     returns -1 on error, else a positive CRT ID
 */
@@ -227,7 +521,7 @@ int crt_read_chip_header(crt_chip_header_t *header, FILE *fd)
 */
 int crt_read_chip(uint8_t *rawcart, int offset, crt_chip_header_t *chip, FILE *fd)
 {
-    if (offset + chip->size > C64CART_IMAGE_LIMIT) {
+    if ((size_t)offset + chip->size > crt_rawcart_size) {
         return -1; /* overflow */
     }
     if (fread(&rawcart[offset], chip->size, 1, fd) < 1) {
@@ -302,7 +596,7 @@ FILE *crt_create(const char *filename, int type, int exrom, int game, const char
     FIXME: to simplify this function a little bit, all subfunctions should
            also return the respective CRT ID on success
 */
-int crt_attach(const char *filename, uint8_t *rawcart)
+int crt_attach(const char *filename, uint8_t *rawcart, size_t size)
 {
     crt_header_t header;
     int rc, new_crttype;
@@ -310,6 +604,10 @@ int crt_attach(const char *filename, uint8_t *rawcart)
 
     DBG(("crt_attach: %s\n", filename));
 
+    crt_rawcart_size = size;
+
+    crt_journal_replay(filename);
+
     fd = crt_open(filename, &header);
 
     if (fd == NULL) {
@@ -46,11 +46,29 @@ typedef struct crt_chip_header_s {
     uint16_t size;                /* size of ROM in bytes */
 } crt_chip_header_t;
 
-extern int crt_attach(const char *filename, uint8_t *rawcart);
+/* a piece of an image file to be written back in place */
+typedef struct crt_chunk_s {
+    long offset;                  /* position in the image file */
+    const uint8_t *data;
+    unsigned int size;
+} crt_chunk_t;
+
+extern int crt_attach(const char *filename, uint8_t *rawcart, size_t size);
 extern int crt_getid(const char *filename);
 extern int crt_read_chip_header(crt_chip_header_t *header, FILE *fd);
 extern int crt_read_chip(uint8_t *rawcart, int offset, crt_chip_header_t *chip, FILE *fd);
 extern FILE *crt_create(const char *filename, int type, int exrom, int game, const char *name);
 extern int crt_write_chip(uint8_t *data, crt_chip_header_t *header, FILE *fd);
+extern int crt_journal_write(const char *filename, const crt_chunk_t *chunks, int num);
+extern int crt_journal_replay(const char *filename);
+
+struct alarm_s;
+struct flash040_context_s;
+
+extern void crt_set_chip_offsets(long *offset, int num, int first, long start, long step);
+extern int crt_is_attached_image(const char *attached, const char *filename);
+extern int crt_flash_write_dirty(const char *filename, struct flash040_context_s **flash,
+                                 int num_flash, const long *offset, int num_chips);
+extern void crt_write_alarm_set(struct alarm_s *alarm, int interval);
 
 #endif
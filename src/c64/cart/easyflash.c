@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "alarm.h"
 #include "archdep.h"
 #define CARTRIDGE_INCLUDE_SLOTMAIN_API
 #include "c64cartsystem.h"
@@ -69,6 +70,11 @@ static int easyflash_crt_write;
 /* optimizing crt enabled */
 static int easyflash_crt_optimize;
 
+/* seconds between writes back to the image, 0 = only on detach */
+static int easyflash_write_interval;
+
+static struct alarm_s *easyflash_write_alarm = NULL;
+
 /* backup of the registers */
 static uint8_t easyflash_register_00, easyflash_register_02;
 
@@ -102,6 +108,10 @@ static uint8_t easyflash_ram[256];
 static char *easyflash_filename = NULL;
 static int easyflash_filetype = 0;
 
+/* file offsets of the ROML (0) and ROMH (1) chips of the attached image, -1
+   for the chips that are not in the file */
+static long easyflash_chip_offset[2][EASYFLASH_N_BANKS];
+
 static const char STRING_EASYFLASH[] = CARTRIDGE_NAME_EASYFLASH;
 
 /* ---------------------------------------------------------------------*/
@@ -213,12 +223,32 @@ static int set_easyflash_crt_optimize(int val, void *param)
     return 0;
 }
 
-static int easyflash_write_chip_if_not_empty(FILE* fd, crt_chip_header_t *chip, uint8_t *data)
+static void easyflash_write_alarm_handler(CLOCK offset, void *data)
+{
+    if (easyflash_crt_write) {
+        easyflash_flush_image();
+    }
+    crt_write_alarm_set(easyflash_write_alarm, easyflash_write_interval);
+}
+
+static int set_easyflash_write_interval(int val, void *param)
+{
+    if (val < 0) {
+        return -1;
+    }
+    easyflash_write_interval = val;
+    crt_write_alarm_set(easyflash_write_alarm, easyflash_write_interval);
+    return 0;
+}
+
+static int easyflash_write_chip_if_not_empty(FILE* fd, crt_chip_header_t *chip, uint8_t *data, long *offset)
 {
     int i;
 
+    *offset = -1;
     for (i = 0; i < chip->size; i++) {
         if ((data[i] != 0xff) || (easyflash_crt_optimize == 0)) {
+            *offset = ftell(fd) + 0x10; /* behind the chip header */
             if (crt_write_chip(data, chip, fd)) {
                 return -1;
             }
@@ -237,6 +267,8 @@ static const resource_int_t resources_int[] = {
       &easyflash_crt_write, set_easyflash_crt_write, NULL },
     { "EasyFlashOptimizeCRT", 1, RES_EVENT_STRICT, (resource_value_t)1,
       &easyflash_crt_optimize, set_easyflash_crt_optimize, NULL },
+    { "EasyFlashWriteInterval", 0, RES_EVENT_NO, (resource_value_t)0,
+      &easyflash_write_interval, set_easyflash_write_interval, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -283,6 +315,11 @@ static const cmdline_option_t cmdline_options[] =
       USE_PARAM_STRING, USE_DESCRIPTION_ID,
       IDCLS_UNUSED, IDCLS_DISABLE_EASYFLASH_CRT_OPTIMIZE,
       NULL, NULL },
+    { "-easyflashwriteinterval", SET_RESOURCE, 1,
+      NULL, NULL, "EasyFlashWriteInterval", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      N_("<Seconds>"), N_("Write changed EasyFlash sectors back to the image every <Seconds> (0: only on detach)") },
     CMDLINE_LIST_END
 };
 
@@ -407,17 +444,39 @@ static int easyflash_common_attach(const char *filename)
 
     easyflash_filename = lib_stralloc(filename);
 
+    easyflash_write_alarm = alarm_new(maincpu_alarm_context, "EasyFlashWriteAlarm", easyflash_write_alarm_handler, NULL);
+    crt_write_alarm_set(easyflash_write_alarm, easyflash_write_interval);
+
     return 0;
 }
 
+/* a bin image holds ROML and ROMH of each bank in turn */
+static void easyflash_set_bin_offsets(long start)
+{
+    crt_set_chip_offsets(easyflash_chip_offset[0], EASYFLASH_N_BANKS, 0, start, 0x4000);
+    crt_set_chip_offsets(easyflash_chip_offset[1], EASYFLASH_N_BANKS, 0, start + 0x2000, 0x4000);
+}
+
 int easyflash_bin_attach(const char *filename, uint8_t *rawcart)
 {
+    FILE *fd;
+
     easyflash_filetype = 0;
 
+    crt_journal_replay(filename);
+
     if (util_file_load(filename, rawcart, 0x4000 * EASYFLASH_N_BANKS, UTIL_FILE_LOAD_SKIP_ADDRESS) < 0) {
         return -1;
     }
 
+    /* skip the load address like util_file_load() does */
+    fd = fopen(filename, MODE_READ);
+    if (fd == NULL) {
+        return -1;
+    }
+    easyflash_set_bin_offsets((util_file_length(fd) & 2) ? 2 : 0);
+    fclose(fd);
+
     easyflash_filetype = CARTRIDGE_FILETYPE_BIN;
     return easyflash_common_attach(filename);
 }
@@ -425,15 +484,21 @@ int easyflash_bin_attach(const char *filename, uint8_t *rawcart)
 int easyflash_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
 {
     crt_chip_header_t chip;
+    long offset;
 
     easyflash_filetype = 0;
     memset(rawcart, 0xff, 0x100000); /* empty flash */
 
+    crt_set_chip_offsets(easyflash_chip_offset[0], EASYFLASH_N_BANKS, EASYFLASH_N_BANKS, 0, 0);
+    crt_set_chip_offsets(easyflash_chip_offset[1], EASYFLASH_N_BANKS, EASYFLASH_N_BANKS, 0, 0);
+
     while (1) {
         if (crt_read_chip_header(&chip, fd)) {
             break;
         }
 
+        offset = ftell(fd);
+
         if (chip.size == 0x2000) {
             if (chip.bank >= EASYFLASH_N_BANKS || !(chip.start == 0x8000 || chip.start == 0xa000 || chip.start == 0xe000)) {
                 return -1;
@@ -441,6 +506,7 @@ int easyflash_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
             if (crt_read_chip(rawcart, (chip.bank << 14) | (chip.start & 0x2000), &chip, fd)) {
                 return -1;
             }
+            easyflash_chip_offset[(chip.start & 0x2000) ? 1 : 0][chip.bank] = offset;
         } else if (chip.size == 0x4000) {
             if (chip.bank >= EASYFLASH_N_BANKS || chip.start != 0x8000) {
                 return -1;
@@ -448,6 +514,8 @@ int easyflash_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
             if (crt_read_chip(rawcart, chip.bank << 14, &chip, fd)) {
                 return -1;
             }
+            easyflash_chip_offset[0][chip.bank] = offset;
+            easyflash_chip_offset[1][chip.bank] = offset + 0x2000;
         } else {
             return -1;
         }
@@ -462,6 +530,8 @@ void easyflash_detach(void)
     if (easyflash_crt_write) {
         easyflash_flush_image();
     }
+    alarm_destroy(easyflash_write_alarm);
+    easyflash_write_alarm = NULL;
     flash040core_shutdown(easyflash_state_low);
     flash040core_shutdown(easyflash_state_high);
     lib_free(easyflash_state_low);
@@ -477,13 +547,28 @@ void easyflash_detach(void)
 
 int easyflash_flush_image(void)
 {
+    flash040_context_t *state[2];
+    int rc;
+
     if (easyflash_filename != NULL) {
-        if (easyflash_filetype == CARTRIDGE_FILETYPE_BIN) {
-            return easyflash_bin_save(easyflash_filename);
-        } else if (easyflash_filetype == CARTRIDGE_FILETYPE_CRT) {
-            return easyflash_crt_save(easyflash_filename);
+        if (easyflash_filetype != CARTRIDGE_FILETYPE_BIN && easyflash_filetype != CARTRIDGE_FILETYPE_CRT) {
+            return -1;
         }
-        return -1;
+        state[0] = easyflash_state_low;
+        state[1] = easyflash_state_high;
+        rc = crt_flash_write_dirty(easyflash_filename, state, 2, &easyflash_chip_offset[0][0], EASYFLASH_N_BANKS);
+        if (rc > 0) {
+            if (easyflash_filetype == CARTRIDGE_FILETYPE_BIN) {
+                rc = easyflash_bin_save(easyflash_filename);
+            } else {
+                rc = easyflash_crt_save(easyflash_filename);
+            }
+        }
+        if (rc == 0) {
+            flash040core_clear_dirty(easyflash_state_low);
+            flash040core_clear_dirty(easyflash_state_high);
+        }
+        return rc;
     }
     return -2;
 }
@@ -516,6 +601,10 @@ int easyflash_bin_save(const char *filename)
     }
 
     fclose(fd);
+
+    if (crt_is_attached_image(easyflash_filename, filename)) {
+        easyflash_set_bin_offsets(0);
+    }
     return 0;
 }
 
@@ -524,6 +613,7 @@ int easyflash_crt_save(const char *filename)
     FILE *fd;
     crt_chip_header_t chip;
     uint8_t *data;
+    long offset[2][EASYFLASH_N_BANKS];
     int bank;
 
     fd = crt_create(filename, CARTRIDGE_EASYFLASH, 1, 0, STRING_EASYFLASH);
@@ -540,19 +630,23 @@ int easyflash_crt_save(const char *filename)
 
         data = easyflash_state_low->flash_data + bank * 0x2000;
         chip.start = 0x8000;
-        if (easyflash_write_chip_if_not_empty(fd, &chip, data) != 0) {
+        if (easyflash_write_chip_if_not_empty(fd, &chip, data, &offset[0][bank]) != 0) {
             fclose(fd);
             return -1;
         }
 
         data = easyflash_state_high->flash_data + bank * 0x2000;
         chip.start = 0xa000;
-        if (easyflash_write_chip_if_not_empty(fd, &chip, data) != 0) {
+        if (easyflash_write_chip_if_not_empty(fd, &chip, data, &offset[1][bank]) != 0) {
             fclose(fd);
             return -1;
         }
     }
     fclose(fd);
+
+    if (crt_is_attached_image(easyflash_filename, filename)) {
+        memcpy(easyflash_chip_offset, offset, sizeof(offset));
+    }
     return 0;
 }
 
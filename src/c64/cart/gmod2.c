@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "alarm.h"
 #include "archdep.h"
 #include "c64cart.h"
 #define CARTRIDGE_INCLUDE_SLOTMAIN_API
@@ -91,12 +92,21 @@ static int gmod2_cmode = CMODE_8KGAME;
 static int gmod2_bank;
 static int gmod2_flash_write = 0;
 
+/* seconds between writes back to the image, 0 = only on detach */
+static int gmod2_flash_write_interval = 0;
+
+static struct alarm_s *gmod2_write_alarm = NULL;
+
 /* the 29F010 statemachine */
 static flash040_context_t *flashrom_state = NULL;
 
 static char *gmod2_filename = NULL;
 static int gmod2_filetype = 0;
 
+/* file offsets of the 8KiB chips of the attached image, -1 for the chips
+   that are not in the file */
+static long gmod2_chip_offset[GMOD2_FLASH_SIZE / 0x2000];
+
 static char *gmod2_eeprom_filename = NULL;
 static int gmod2_eeprom_rw = 0;
 
@@ -310,6 +320,24 @@ static int set_gmod2_flash_write(int val, void *param)
     return 0;
 }
 
+static void gmod2_write_alarm_handler(CLOCK offset, void *data)
+{
+    if (gmod2_flash_write && flashrom_state->flash_dirty) {
+        gmod2_flush_image();
+    }
+    crt_write_alarm_set(gmod2_write_alarm, gmod2_flash_write_interval);
+}
+
+static int set_gmod2_flash_write_interval(int val, void *param)
+{
+    if (val < 0) {
+        return -1;
+    }
+    gmod2_flash_write_interval = val;
+    crt_write_alarm_set(gmod2_write_alarm, gmod2_flash_write_interval);
+    return 0;
+}
+
 static const resource_string_t resources_string[] = {
     { "GMod2EEPROMImage", "", RES_EVENT_NO, NULL,
       &gmod2_eeprom_filename, set_gmod2_eeprom_filename, NULL },
@@ -319,6 +347,8 @@ static const resource_string_t resources_string[] = {
 static const resource_int_t resources_int[] = {
     { "GMod2FlashWrite", 0, RES_EVENT_NO, NULL,
       &gmod2_flash_write, set_gmod2_flash_write, NULL },
+    { "GMod2FlashWriteInterval", 0, RES_EVENT_NO, NULL,
+      &gmod2_flash_write_interval, set_gmod2_flash_write_interval, NULL },
     { "GMod2EEPROMRW", 1, RES_EVENT_NO, NULL,
       &gmod2_eeprom_rw, set_gmod2_eeprom_rw, NULL },
     RESOURCE_INT_LIST_END
@@ -366,6 +396,11 @@ static const cmdline_option_t cmdline_options[] =
       USE_PARAM_STRING, USE_DESCRIPTION_ID,
       IDCLS_UNUSED, IDCLS_DISABLE_SAVE_GMOD2_ROM_AT_EXIT,
       NULL, NULL },
+    { "-gmod2flashwriteinterval", SET_RESOURCE, 1,
+      NULL, NULL, "GMod2FlashWriteInterval", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      N_("<Seconds>"), N_("Write changed GMod2 sectors back to the image every <Seconds> (0: only on detach)") },
     CMDLINE_LIST_END
 };
 
@@ -385,18 +420,33 @@ static int gmod2_common_attach(void)
 
     gmod2_enabled = 1;
 
+    gmod2_write_alarm = alarm_new(maincpu_alarm_context, "GMod2WriteAlarm", gmod2_write_alarm_handler, NULL);
+    crt_write_alarm_set(gmod2_write_alarm, gmod2_flash_write_interval);
+
     return 0;
 }
 
 int gmod2_bin_attach(const char *filename, uint8_t *rawcart)
 {
+    FILE *fd;
+
     gmod2_filetype = 0;
     gmod2_filename = NULL;
 
+    crt_journal_replay(filename);
+
     if (util_file_load(filename, rawcart, GMOD2_FLASH_SIZE, UTIL_FILE_LOAD_SKIP_ADDRESS) < 0) {
         return -1;
     }
 
+    /* skip the load address like util_file_load() does */
+    fd = fopen(filename, MODE_READ);
+    if (fd == NULL) {
+        return -1;
+    }
+    crt_set_chip_offsets(gmod2_chip_offset, GMOD2_FLASH_SIZE / 0x2000, 0, (util_file_length(fd) & 2) ? 2 : 0, 0x2000);
+    fclose(fd);
+
     gmod2_filetype = CARTRIDGE_FILETYPE_BIN;
     gmod2_filename = lib_stralloc(filename);
     return gmod2_common_attach();
@@ -412,6 +462,8 @@ int gmod2_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
     gmod2_filetype = 0;
     gmod2_filename = NULL;
 
+    crt_set_chip_offsets(gmod2_chip_offset, GMOD2_FLASH_SIZE / 0x2000, GMOD2_FLASH_SIZE / 0x2000, 0, 0);
+
     for (i = 0; i <= 63; i++) {
         if (crt_read_chip_header(&chip, fd)) {
             break;
@@ -421,6 +473,8 @@ int gmod2_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
             return -1;
         }
 
+        gmod2_chip_offset[chip.bank] = ftell(fd);
+
         if (crt_read_chip(rawcart, chip.bank << 13, &chip, fd)) {
             return -1;
         }
@@ -453,6 +507,10 @@ int gmod2_bin_save(const char *filename)
 
     fclose(fd);
 
+    if (crt_is_attached_image(gmod2_filename, filename)) {
+        crt_set_chip_offsets(gmod2_chip_offset, GMOD2_FLASH_SIZE / 0x2000, 0, 0, 0x2000);
+    }
+
     return 0;
 }
 
@@ -461,6 +519,7 @@ int gmod2_crt_save(const char *filename)
     FILE *fd;
     crt_chip_header_t chip;
     uint8_t *data;
+    long offset[GMOD2_FLASH_SIZE / 0x2000];
     int i;
 
     fd = crt_create(filename, CARTRIDGE_GMOD2, 1, 0, STRING_GMOD2);
@@ -478,6 +537,7 @@ int gmod2_crt_save(const char *filename)
     for (i = 0; i < 64; i++) {
         chip.bank = i; /* bank */
 
+        offset[i] = ftell(fd) + 0x10; /* behind the chip header */
         if (crt_write_chip(data, &chip, fd)) {
             fclose(fd);
             return -1;
@@ -486,17 +546,33 @@ int gmod2_crt_save(const char *filename)
     }
 
     fclose(fd);
+
+    if (crt_is_attached_image(gmod2_filename, filename)) {
+        memcpy(gmod2_chip_offset, offset, sizeof(offset));
+    }
     return 0;
 }
 
 int gmod2_flush_image(void)
 {
-    if (gmod2_filetype == CARTRIDGE_FILETYPE_BIN) {
-        return gmod2_bin_save(gmod2_filename);
-    } else if (gmod2_filetype == CARTRIDGE_FILETYPE_CRT) {
-        return gmod2_crt_save(gmod2_filename);
+    int rc;
+
+    if (gmod2_filetype != CARTRIDGE_FILETYPE_BIN && gmod2_filetype != CARTRIDGE_FILETYPE_CRT) {
+        return -1;
     }
-    return -1;
+
+    rc = crt_flash_write_dirty(gmod2_filename, &flashrom_state, 1, gmod2_chip_offset, GMOD2_FLASH_SIZE / 0x2000);
+    if (rc > 0) {
+        if (gmod2_filetype == CARTRIDGE_FILETYPE_BIN) {
+            rc = gmod2_bin_save(gmod2_filename);
+        } else {
+            rc = gmod2_crt_save(gmod2_filename);
+        }
+    }
+    if (rc == 0) {
+        flash040core_clear_dirty(flashrom_state);
+    }
+    return rc;
 }
 
 void gmod2_detach(void)
@@ -504,6 +580,8 @@ void gmod2_detach(void)
     if (gmod2_flash_write && flashrom_state->flash_dirty) {
         gmod2_flush_image();
     }
+    alarm_destroy(gmod2_write_alarm);
+    gmod2_write_alarm = NULL;
 
     flash040core_shutdown(flashrom_state);
     lib_free(flashrom_state);
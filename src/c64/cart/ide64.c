@@ -130,6 +130,7 @@ static int ft245_rxp, ft245_rxl, ft245_txp;
 #endif
 
 static int settings_version;
+static int settings_cache_size;
 static int ide64_rtc_save;
 
 /* Current clockport device */
@@ -558,6 +559,23 @@ static int ide64_set_rtc_save(int val, void *param)
     return 0;
 }
 
+static int set_cache_size(int value, void *param)
+{
+    int i;
+
+    if (value < 0) {
+        value = 0;
+    }
+    settings_cache_size = value;
+
+    for (i = 0; i < 4; i++) {
+        if (drives[i].drv) {
+            ata_set_cache_size(drives[i].drv, settings_cache_size);
+        }
+    }
+    return 0;
+}
+
 static int set_version(int value, void *param)
 {
     int val;
@@ -775,6 +793,9 @@ static const resource_int_t resources_int[] = {
     { "IDE64RTCSave", 0,
       RES_EVENT_NO, NULL,
       &ide64_rtc_save, ide64_set_rtc_save, NULL },
+    { "IDE64CacheSize", 256,
+      RES_EVENT_NO, NULL,
+      &settings_cache_size, set_cache_size, NULL },
     { "IDE64ClockPort", 0, RES_EVENT_NO, NULL,
       &clockport_device_id, set_ide64_clockport_device, NULL },
     RESOURCE_INT_LIST_END
@@ -983,6 +1004,11 @@ static const cmdline_option_t cmdline_options[] = {
       USE_PARAM_STRING, USE_DESCRIPTION_ID,
       IDCLS_UNUSED, IDCLS_DISABLE_IDE64_RTC_SAVE,
       NULL, NULL },
+    { "-IDE64cachesize", SET_RESOURCE, 1,
+      NULL, NULL, "IDE64CacheSize", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      N_("<KiB>"), N_("Size of the sector cache of each IDE64 device in KiB (0: disabled)") },
     CMDLINE_LIST_END
 };
 
@@ -1599,6 +1625,7 @@ static int ide64_common_attach(uint8_t *rawcart, int detect)
     for (i = 0; i < 4; i++) {
         if (!drives[i].drv) {
             drives[i].drv = ata_init(i);
+            ata_set_cache_size(drives[i].drv, settings_cache_size);
         }
         drives[i].update_needed = 1;
     }
@@ -1752,6 +1779,7 @@ int ide64_snapshot_read_module(snapshot_t *s)
     for (i = 0; i < 4; i++) {
         if (!drives[i].drv) {
             drives[i].drv = ata_init(i);
+            ata_set_cache_size(drives[i].drv, settings_cache_size);
             detect_ide64_image(&drives[i]);
             ata_image_attach(drives[i].drv, drives[i].filename, drives[i].type, drives[i].detected);
         }
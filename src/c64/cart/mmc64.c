@@ -1446,6 +1446,9 @@ int mmc64_snapshot_write_module(snapshot_t *s)
 {
     snapshot_module_t *m;
 
+    /* the card image is not part of the snapshot, but it has to match it */
+    mmc_flush_card_image();
+
     m = snapshot_module_create(s, snap_module_name, SNAP_MAJOR, SNAP_MINOR);
 
     if (m == NULL) {
@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "alarm.h"
 #include "archdep.h"
 #define CARTRIDGE_INCLUDE_SLOTMAIN_API
 #include "c64cartsystem.h"
@@ -123,8 +124,17 @@ static int mmcr_sd_type = 0;
 static char *mmcr_filename = NULL;
 static int mmcr_filetype = 0;
 
+/* file offsets of the 8KiB chips of the attached image, -1 for the chips
+   that are not in the file */
+static long mmcr_chip_offset[MMCREPLAY_FLASHROM_SIZE / 0x2000];
+
 static int mmcr_write_image = 0;
 
+/* seconds between writes back to the image, 0 = only on detach */
+static int mmcr_write_image_interval = 0;
+
+static struct alarm_s *mmcr_write_alarm = NULL;
+
 static const char STRING_MMC_REPLAY[] = CARTRIDGE_NAME_MMC_REPLAY;
 
 /*
@@ -2583,6 +2593,14 @@ static int clockport_deactivate(void)
 
 /* ------------------------------------------------------------------------- */
 
+static void mmcreplay_write_alarm_handler(CLOCK offset, void *data)
+{
+    if (mmcr_write_image && flashrom_state->flash_dirty) {
+        mmcreplay_flush_image();
+    }
+    crt_write_alarm_set(mmcr_write_alarm, mmcr_write_image_interval);
+}
+
 static int mmcreplay_common_attach(const char *filename)
 {
     if (export_add(&export_res) < 0) {
@@ -2603,17 +2621,30 @@ static int mmcreplay_common_attach(const char *filename)
     eeprom_open_image(mmcr_eeprom_filename, mmcr_eeprom_rw);
 
     mmcr_filename = lib_stralloc(filename);
+
+    mmcr_write_alarm = alarm_new(maincpu_alarm_context, "MMCReplayWriteAlarm", mmcreplay_write_alarm_handler, NULL);
+    crt_write_alarm_set(mmcr_write_alarm, mmcr_write_image_interval);
     return 0;
 }
 
+/* Set the chip offsets of a bin image holding `size' bytes of flash from its
+   end, -1 for the chips in front of it.  */
+static void mmcreplay_set_bin_offsets(long start, int size)
+{
+    crt_set_chip_offsets(mmcr_chip_offset, MMCREPLAY_FLASHROM_SIZE / 0x2000,
+                         (MMCREPLAY_FLASHROM_SIZE - size) / 0x2000, start, 0x2000);
+}
+
 int mmcreplay_bin_attach(const char *filename, uint8_t *rawcart)
 {
-    int len = 0;
+    int len = 0, size;
     FILE *fd;
 
     mmcr_filetype = 0;
     mmcr_filename = NULL;
 
+    crt_journal_replay(filename);
+
     if (util_file_load(filename, rawcart, MMCREPLAY_FLASHROM_SIZE,
                        UTIL_FILE_LOAD_SKIP_ADDRESS | UTIL_FILE_LOAD_FILL) < 0) {
         return -1;
@@ -2622,8 +2653,18 @@ int mmcreplay_bin_attach(const char *filename, uint8_t *rawcart)
     fd = fopen(filename, "rb");
     len = util_file_length(fd);
     fclose(fd);
+    /* without the load address, like util_file_load() skips it */
+    size = len - (len & 2);
+
+    /* only the plain full size and last sector images can be written back
+       in place, smaller ones are mirrored */
+    if (size == MMCREPLAY_FLASHROM_SIZE || size == 0x10000) {
+        mmcreplay_set_bin_offsets(len & 2, size);
+    } else {
+        mmcreplay_set_bin_offsets(0, 0);
+    }
 
-    if (len == 0x10000) {
+    if (size == 0x10000) {
         if (util_file_load(filename, &rawcart[7 * 0x10000], 0x10000,
                            UTIL_FILE_LOAD_SKIP_ADDRESS | UTIL_FILE_LOAD_FILL) < 0) {
             return -1;
@@ -2643,6 +2684,7 @@ int mmcreplay_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
     mmcr_filename = NULL;
 
     memset(rawcart, 0xff, 0x80000);
+    mmcreplay_set_bin_offsets(0, 0);
 
     for (i = 0; i <= 63; i++) {
         if (crt_read_chip_header(&chip, fd)) {
@@ -2653,6 +2695,10 @@ int mmcreplay_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
             return -1;
         }
 
+        if (chip.size == 0x2000) {
+            mmcr_chip_offset[chip.bank] = ftell(fd);
+        }
+
         if (crt_read_chip(rawcart, chip.bank << 13, &chip, fd)) {
             return -1;
         }
@@ -2665,6 +2711,10 @@ int mmcreplay_crt_attach(FILE *fd, uint8_t *rawcart, const char *filename)
     if (i == 8) {
         memcpy(&rawcart[7 * 0x10000], &rawcart[0], 0x10000);
         memset(&rawcart[0], 0xff, 0x10000);
+        memcpy(&mmcr_chip_offset[7 * 8], &mmcr_chip_offset[0], 8 * sizeof(long));
+        for (i = 0; i < 8; i++) {
+            mmcr_chip_offset[i] = -1;
+        }
     }
 
     mmcr_filetype = CARTRIDGE_FILETYPE_CRT;
@@ -2709,13 +2759,19 @@ int mmcreplay_bin_save(const char *filename)
             fclose(fd);
             return -1;
         }
+        n = 0x10000;
     } else {
         if (fwrite(&roml_banks[0x00000], 1, 0x10000 * 8, fd) != (0x10000 * 8)) {
             fclose(fd);
             return -1;
         }
+        n = 0x10000 * 8;
     }
     fclose(fd);
+
+    if (crt_is_attached_image(mmcr_filename, filename)) {
+        mmcreplay_set_bin_offsets(0, n);
+    }
     return 0;
 }
 
@@ -2724,6 +2780,7 @@ int mmcreplay_crt_save(const char *filename)
     FILE *fd;
     crt_chip_header_t chip;
     uint8_t *data;
+    long offset[MMCREPLAY_FLASHROM_SIZE / 0x2000];
     int i, n = 0;
 
     fd = crt_create(filename, CARTRIDGE_MMC_REPLAY, 1, 0, STRING_MMC_REPLAY);
@@ -2742,12 +2799,17 @@ int mmcreplay_crt_save(const char *filename)
     chip.size = 0x2000;
     chip.start = 0x8000;
 
+    for (i = 0; i < MMCREPLAY_FLASHROM_SIZE / 0x2000; i++) {
+        offset[i] = -1;
+    }
+
     if ((!checkempty(7)) && (n == 7)) {
         data = &roml_banks[0x70000];
 
         for (i = 0; i < 8; i++) {
             chip.bank = i + (7 * 8); /* bank */
 
+            offset[chip.bank] = ftell(fd) + 0x10; /* behind the chip header */
             if (crt_write_chip(data, &chip, fd)) {
                 fclose(fd);
                 return -1;
@@ -2760,6 +2822,7 @@ int mmcreplay_crt_save(const char *filename)
         for (i = 0; i < (8 * 8); i++) {
             chip.bank = i; /* bank */
 
+            offset[chip.bank] = ftell(fd) + 0x10; /* behind the chip header */
             if (crt_write_chip(data, &chip, fd)) {
                 fclose(fd);
                 return -1;
@@ -2768,18 +2831,33 @@ int mmcreplay_crt_save(const char *filename)
         }
     }
     fclose(fd);
+
+    if (crt_is_attached_image(mmcr_filename, filename)) {
+        memcpy(mmcr_chip_offset, offset, sizeof(offset));
+    }
     return 0;
 }
 
-
 int mmcreplay_flush_image(void)
 {
-    if (mmcr_filetype == CARTRIDGE_FILETYPE_BIN) {
-        return mmcreplay_bin_save(mmcr_filename);
-    } else if (mmcr_filetype == CARTRIDGE_FILETYPE_CRT) {
-        return mmcreplay_crt_save(mmcr_filename);
+    int rc;
+
+    if (mmcr_filetype != CARTRIDGE_FILETYPE_BIN && mmcr_filetype != CARTRIDGE_FILETYPE_CRT) {
+        return -1;
     }
-    return -1;
+
+    rc = crt_flash_write_dirty(mmcr_filename, &flashrom_state, 1, mmcr_chip_offset, MMCREPLAY_FLASHROM_SIZE / 0x2000);
+    if (rc > 0) {
+        if (mmcr_filetype == CARTRIDGE_FILETYPE_BIN) {
+            rc = mmcreplay_bin_save(mmcr_filename);
+        } else {
+            rc = mmcreplay_crt_save(mmcr_filename);
+        }
+    }
+    if (rc == 0) {
+        flash040core_clear_dirty(flashrom_state);
+    }
+    return rc;
 }
 
 void mmcreplay_detach(void)
@@ -2787,6 +2865,8 @@ void mmcreplay_detach(void)
     if (mmcr_write_image && flashrom_state->flash_dirty) {
         mmcreplay_flush_image();
     }
+    alarm_destroy(mmcr_write_alarm);
+    mmcr_write_alarm = NULL;
 
     flash040core_shutdown(flashrom_state);
     lib_free(flashrom_state);
@@ -2902,6 +2982,16 @@ static int set_mmcr_image_write(int val, void *param)
     return 0;
 }
 
+static int set_mmcr_image_write_interval(int val, void *param)
+{
+    if (val < 0) {
+        return -1;
+    }
+    mmcr_write_image_interval = val;
+    crt_write_alarm_set(mmcr_write_alarm, mmcr_write_image_interval);
+    return 0;
+}
+
 static const resource_string_t resources_string[] = {
     { "MMCRCardImage", "", RES_EVENT_NO, NULL,
       &mmcr_card_filename, set_mmcr_card_filename, NULL },
@@ -2915,6 +3005,8 @@ static const resource_int_t resources_int[] = {
       &enable_rescue_mode, set_mmcr_rescue_mode, NULL },
     { "MMCRImageWrite", 0, RES_EVENT_NO, NULL,
       &mmcr_write_image, set_mmcr_image_write, NULL },
+    { "MMCRImageWriteInterval", 0, RES_EVENT_NO, NULL,
+      &mmcr_write_image_interval, set_mmcr_image_write_interval, NULL },
     { "MMCRCardRW", 1, RES_EVENT_NO, NULL,
       &mmcr_card_rw, set_mmcr_card_rw, NULL },
     { "MMCRSDType", MMCR_TYPE_AUTO, RES_EVENT_NO, NULL,
@@ -2963,6 +3055,11 @@ static const cmdline_option_t cmdline_options[] = {
       USE_PARAM_STRING, USE_DESCRIPTION_ID,
       IDCLS_UNUSED, IDCLS_DO_NOT_WRITE_TO_MMC_REPLAY_IMAGE,
       NULL, NULL },
+    { "-mmcrimagewriteinterval", SET_RESOURCE, 1,
+      NULL, NULL, "MMCRImageWriteInterval", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      N_("<Seconds>"), N_("Write changed MMC Replay sectors back to the image every <Seconds> (0: only on detach)") },
     { "-mmcrcardimage", SET_RESOURCE, 1,
       NULL, NULL, "MMCRCardImage", NULL,
       USE_PARAM_ID, USE_DESCRIPTION_ID,
@@ -3049,6 +3146,8 @@ int mmcreplay_cmdline_options_init(void)
 /* FIXME: implement snapshot support */
 int mmcreplay_snapshot_write_module(snapshot_t *s)
 {
+    /* the card image is not part of the snapshot, but it has to match it */
+    mmc_flush_card_image();
     return -1;
 #if 0
     snapshot_module_t *m;
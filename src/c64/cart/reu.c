@@ -43,6 +43,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "alarm.h"
 #include "archdep.h"
 #include "cartio.h"
 #include "cartridge.h"
@@ -115,6 +116,9 @@ static debug_level_e DEBUG_LEVEL = DEBUG_LEVEL_TRANSFER_LOW_LEVEL;
 /*! \brief Shortcut to check for masked bits being all cleared */
 #define BITS_ARE_ALL_UNSET(_where, _bits) ((((_where) & (_bits)) == 0))
 
+/*! \brief Shortcut to get the smaller of two values */
+#define MIN(_a, _b) (((_a) < (_b)) ? (_a) : (_b))
+
 /*
  * Status and Command Registers
  * bit  7       6       5       4       3       2       1       0
@@ -253,6 +257,16 @@ static struct reu_ba_s reu_ba = {
     NULL, NULL, NULL, 0, 0, 0, 0
 };
 
+/*! \brief plain RAM pages of the host for block transfers, used for x64 */
+struct reu_host_ram_s {
+    uint8_t ***read_tab;
+    uint8_t ***write_tab;
+};
+
+static struct reu_host_ram_s reu_host_ram = {
+    NULL, NULL
+};
+
 static int reu_write_image = 0;
 
 /* ------------------------------------------------------------------------- */
@@ -602,6 +616,24 @@ void reu_ba_register(reu_ba_check_callback_t *ba_check,
     reu_ba.enabled = 1;
 }
 
+/*! \brief register the plain RAM page tables of the host
+
+  \param read_tab
+    Pointer to the current table of RAM pages that can be read directly
+
+  \param write_tab
+    Pointer to the current table of RAM pages that can be written directly
+
+  \remark
+    The tables hold the base of the RAM for every page that has no side
+    effects on access, and NULL for all other pages.
+*/
+void reu_host_ram_register(uint8_t ***read_tab, uint8_t ***write_tab)
+{
+    reu_host_ram.read_tab = read_tab;
+    reu_host_ram.write_tab = write_tab;
+}
+
 /*! \brief reset the REU */
 void reu_reset(void)
 {
@@ -1088,6 +1120,86 @@ inline static uint8_t read_from_reu(unsigned int reu_addr)
     return value;
 }
 
+/*! \brief get the length of the next block transfer of a DMA operation
+
+  Instead of emulating one byte after the other, a whole block can be
+  transferred at once if the host memory is plain RAM, the REU memory is
+  backed up by DRAM without a wrap around, and no alarm is pending before
+  the end of the block.  This is only done if the host registered its RAM
+  pages, and never with the BA handling of x64sc.
+
+  \param host_addr
+    The host (computer) address where the block starts
+
+  \param reu_addr
+    The REU address where the block starts
+
+  \param host_step
+    The increment to use for the host address; must be either 0 or 1
+
+  \param reu_step
+    The increment to use for the REU address; must be either 0 or 1
+
+  \param len
+    The remaining transfer length of the operation
+
+  \param cycles_per_byte
+    The number of cycles the operation needs for one byte
+
+  \param host_read
+    Nonzero if the operation reads the host memory
+
+  \param host_write
+    Nonzero if the operation writes the host memory
+
+  \return
+    The number of bytes that can be transferred as one block, 0 if the next
+    byte has to be transferred on its own.
+*/
+static int reu_dma_block_length(uint16_t host_addr, unsigned int reu_addr, int host_step, int reu_step, int len,
+                                int cycles_per_byte, int host_read, int host_write)
+{
+    CLOCK next_alarm_clk;
+    CLOCK block_len = (CLOCK)len;
+    unsigned int reu_low = reu_addr & 0x0007ffff;
+    unsigned int dram_addr = reu_addr & (rec_options.dram_wrap_around - 1);
+
+    if (reu_ba.enabled || reu_host_ram.read_tab == NULL) {
+        return 0;
+    }
+    if (host_read && (*reu_host_ram.read_tab == NULL || (*reu_host_ram.read_tab)[host_addr >> 8] == NULL)) {
+        return 0;
+    }
+    if (host_write && (*reu_host_ram.write_tab == NULL || (*reu_host_ram.write_tab)[host_addr >> 8] == NULL)) {
+        return 0;
+    }
+    if (dram_addr >= rec_options.not_backedup_addresses) {
+        return 0;
+    }
+
+    /* every byte handles the alarms which got pending during its cycles */
+    next_alarm_clk = alarm_context_next_pending_clk(maincpu_alarm_context);
+    if (next_alarm_clk <= maincpu_clk) {
+        return 0;
+    }
+    block_len = MIN(block_len, (next_alarm_clk - maincpu_clk - 1) / (CLOCK)cycles_per_byte);
+
+    if (host_step) {
+        block_len = MIN(block_len, 0x100 - (host_addr & 0xff));
+    }
+    if (reu_step) {
+        if (reu_low >= rec_options.wrap_around) {
+            return 0;
+        }
+        block_len = MIN(block_len, rec_options.wrap_around - reu_low - 1);
+        block_len = MIN(block_len, rec_options.not_backedup_addresses - dram_addr);
+        block_len = MIN(block_len, rec_options.dram_wrap_around - dram_addr);
+    }
+
+    assert(block_len <= (CLOCK)len);
+    return (int)block_len;
+}
+
 /* ------------------------------------------------------------------------- */
 
 /*! \brief update the REU registers after a DMA operation
@@ -1180,6 +1292,9 @@ static void reu_dma_update_regs(uint16_t host_addr, unsigned int reu_addr, int l
 static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int host_step, int reu_step, int len)
 {
     uint8_t value;
+    uint8_t *host;
+    uint8_t *reu;
+    int block_len;
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "copy ext $%05X %s<= main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1198,6 +1313,24 @@ static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int h
         host_addr = (host_addr + host_step) & 0xffff;
         reu_addr = increment_reu_with_wrap_around(reu_addr, reu_step);
         len--;
+
+        block_len = reu_dma_block_length(host_addr, reu_addr, host_step, reu_step, len, 1, 1, 0);
+        if (block_len > 0) {
+            DEBUG_LOG(DEBUG_LEVEL_TRANSFER_LOW_LEVEL, (reu_log, "Transferring block: %d bytes from main $%04X to ext $%05X.", block_len, host_addr, reu_addr));
+            host = (*reu_host_ram.read_tab)[host_addr >> 8] + host_addr;
+            reu = reu_ram + (reu_addr & (rec_options.dram_wrap_around - 1));
+            if (!reu_step) {
+                *reu = host[host_step ? block_len - 1 : 0];
+            } else if (!host_step) {
+                memset(reu, *host, (size_t)block_len);
+            } else {
+                memcpy(reu, host, (size_t)block_len);
+            }
+            maincpu_clk += block_len;
+            host_addr = (host_addr + host_step * block_len) & 0xffff;
+            reu_addr += reu_step * block_len;
+            len -= block_len;
+        }
     }
     DEBUG_LOG(DEBUG_LEVEL_REGISTER2, (reu_log, "END OF BLOCK"));
     reu_dma_update_regs(host_addr, reu_addr, ++len, REU_REG_R_STATUS_END_OF_BLOCK);
@@ -1223,6 +1356,9 @@ static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int h
 static void reu_dma_reu_to_host(uint16_t host_addr, unsigned int reu_addr, int host_step, int reu_step, int len)
 {
     uint8_t value;
+    uint8_t *host;
+    uint8_t *reu;
+    int block_len;
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "copy ext $%05X %s=> main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1240,6 +1376,24 @@ static void reu_dma_reu_to_host(uint16_t host_addr, unsigned int reu_addr, int h
         host_addr = (host_addr + host_step) & 0xffff;
         reu_addr = increment_reu_with_wrap_around(reu_addr, reu_step);
         len--;
+
+        block_len = reu_dma_block_length(host_addr, reu_addr, host_step, reu_step, len, 1, 0, 1);
+        if (block_len > 0) {
+            DEBUG_LOG(DEBUG_LEVEL_TRANSFER_LOW_LEVEL, (reu_log, "Transferring block: %d bytes from ext $%05X to main $%04X.", block_len, reu_addr, host_addr));
+            host = (*reu_host_ram.write_tab)[host_addr >> 8] + host_addr;
+            reu = reu_ram + (reu_addr & (rec_options.dram_wrap_around - 1));
+            if (!host_step) {
+                *host = reu[reu_step ? block_len - 1 : 0];
+            } else if (!reu_step) {
+                memset(host, *reu, (size_t)block_len);
+            } else {
+                memcpy(host, reu, (size_t)block_len);
+            }
+            maincpu_clk += block_len;
+            host_addr = (host_addr + host_step * block_len) & 0xffff;
+            reu_addr += reu_step * block_len;
+            len -= block_len;
+        }
     }
     if (reu_ba.enabled && reu_ba.last_cycle) { /* extra cycle if ended while BA set */
        machine_handle_pending_alarms(0);
@@ -1270,6 +1424,11 @@ static void reu_dma_swap(uint16_t host_addr, unsigned int reu_addr, int host_ste
 {
     uint8_t value_from_reu;
     uint8_t value_from_c64;
+    uint8_t *host_read;
+    uint8_t *host_write;
+    uint8_t *reu;
+    int block_len;
+    int i;
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "swap ext $%05X %s<=> main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1292,6 +1451,27 @@ static void reu_dma_swap(uint16_t host_addr, unsigned int reu_addr, int host_ste
         host_addr = (host_addr + host_step) & 0xffff;
         reu_addr = increment_reu_with_wrap_around(reu_addr, reu_step);
         len--;
+
+        /* fixed addresses are left to the byte transfer */
+        if (!host_step || !reu_step) {
+            continue;
+        }
+        block_len = reu_dma_block_length(host_addr, reu_addr, host_step, reu_step, len, 2, 1, 1);
+        if (block_len > 0) {
+            DEBUG_LOG(DEBUG_LEVEL_TRANSFER_LOW_LEVEL, (reu_log, "Exchanging block: %d bytes of main $%04X with ext $%05X.", block_len, host_addr, reu_addr));
+            host_read = (*reu_host_ram.read_tab)[host_addr >> 8] + host_addr;
+            host_write = (*reu_host_ram.write_tab)[host_addr >> 8] + host_addr;
+            reu = reu_ram + (reu_addr & (rec_options.dram_wrap_around - 1));
+            for (i = 0; i < block_len; i++) {
+                value_from_reu = reu[i];
+                reu[i] = host_read[i];
+                host_write[i] = value_from_reu;
+            }
+            maincpu_clk += 2 * block_len;
+            host_addr = (host_addr + block_len) & 0xffff;
+            reu_addr += block_len;
+            len -= block_len;
+        }
     }
     if (reu_ba.enabled && reu_ba.last_cycle) { /* extra cycle if ended while BA set */
        machine_handle_pending_alarms(0);       /* likely needed, but not confirmed yet */
@@ -1325,6 +1505,10 @@ static void reu_dma_compare(uint16_t host_addr, unsigned int reu_addr, int host_
 
     uint8_t new_status_or_mask = 0;
 
+    uint8_t *host;
+    uint8_t *reu;
+    int block_len;
+
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "compare ext $%05X %s<=> main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1363,6 +1547,26 @@ static void reu_dma_compare(uint16_t host_addr, unsigned int reu_addr, int host_
             }
             break;
         }
+
+        /* fixed addresses are left to the byte transfer */
+        if (!host_step || !reu_step) {
+            continue;
+        }
+        block_len = reu_dma_block_length(host_addr, reu_addr, host_step, reu_step, len, 1, 1, 0);
+        if (block_len > 0) {
+            host = (*reu_host_ram.read_tab)[host_addr >> 8] + host_addr;
+            reu = reu_ram + (reu_addr & (rec_options.dram_wrap_around - 1));
+            if (memcmp(host, reu, (size_t)block_len) != 0) {
+                /* only the bytes before the difference; it is verified on its own */
+                for (block_len = 0; host[block_len] == reu[block_len]; block_len++) {
+                }
+            }
+            DEBUG_LOG(DEBUG_LEVEL_TRANSFER_LOW_LEVEL, (reu_log, "Comparing block: %d bytes of main $%04X with ext $%05X.", block_len, host_addr, reu_addr));
+            maincpu_clk += block_len;
+            host_addr = (host_addr + block_len) & 0xffff;
+            reu_addr += block_len;
+            len -= block_len;
+        }
     }
 
     /* the length was decremented once too much, correct this */
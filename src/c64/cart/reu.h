@@ -47,6 +47,7 @@ typedef void reu_ba_steal_callback_t (void);
 extern void reu_ba_register(reu_ba_check_callback_t *ba_check,
                             reu_ba_steal_callback_t *ba_steal,
                             int *ba_var, int ba_mask);
+extern void reu_host_ram_register(uint8_t ***read_tab, uint8_t ***write_tab);
 
 extern void reu_reset(void);
 extern void reu_dma(int immed);
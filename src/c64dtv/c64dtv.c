@@ -897,6 +897,16 @@ int machine_read_snapshot(const char *name, int event_mode)
     return c64dtv_snapshot_read(name, event_mode);
 }
 
+int machine_write_snapshot_mem(uint8_t **data_return, size_t *size_return, int save_roms, int save_disks, int event_mode)
+{
+    return -1;
+}
+
+int machine_read_snapshot_mem(const uint8_t *data, size_t size, int event_mode)
+{
+    return -1;
+}
+
 /* ------------------------------------------------------------------------- */
 
 int machine_screenshot(screenshot_t *screenshot, struct video_canvas_s *canvas)
@@ -950,6 +950,16 @@ int machine_read_snapshot(const char *name, int event_mode)
     return cbm2_snapshot_read(name, event_mode);
 }
 
+int machine_write_snapshot_mem(uint8_t **data_return, size_t *size_return, int save_roms, int save_disks, int event_mode)
+{
+    return -1;
+}
+
+int machine_read_snapshot_mem(const uint8_t *data, size_t size, int event_mode)
+{
+    return -1;
+}
+
 /* ------------------------------------------------------------------------- */
 
 int machine_autodetect_psid(const char *name)
@@ -74,6 +74,14 @@
 #define putw(a, b) {result[(a) * 2] = (b) & 0xff; result[(a) * 2 + 1] = (b) >> 8; }
 #define setb(a, b, c) {result[(a) * 2 + (b) / 8] |= (c) ? (1 << ((b) & 7)) : 0; }
 
+/* sectors read at least on a cache miss */
+#define ATA_READ_AHEAD 16
+
+typedef struct ata_cache_slot_s {
+    int lba; /* -1 if unused */
+    int dirty;
+} ata_cache_slot_t;
+
 struct ata_drive_s {
     uint8_t error;
     uint8_t features;
@@ -112,6 +120,10 @@ struct ata_drive_s {
     CLOCK seek_time;
     CLOCK spinup_time, spindown_time;
     CLOCK cycles_1s;
+    int cache_size; /* KiB */
+    int cache_slots;
+    ata_cache_slot_t *cache_slot;
+    uint8_t *cache_data;
 };
 
 static const uint8_t identify[128] = {
@@ -259,6 +271,151 @@ static int seek_sector(ata_drive_t *drv)
     return drv->error;
 }
 
+/* Sector cache
+
+   The image is accessed through a direct mapped cache of whole sectors.  A
+   read that misses fetches the remaining sectors of the command, but at
+   least ATA_READ_AHEAD, with a single access of the image.  Written sectors
+   are only marked dirty, and written back in runs of adjacent sectors at the
+   end of a write command (unless the write cache is enabled), on FLUSH CACHE,
+   when the write cache gets disabled, before a snapshot is written, when the
+   image is detached, or when their slot is needed for an other sector.  The
+   emulated busy times are still only set by the alarms.  */
+
+static void ata_cache_alloc(ata_drive_t *drv)
+{
+    int i;
+
+    drv->cache_slots = drv->cache_size * 1024 / drv->sector_size;
+    if (drv->cache_slots < 1) {
+        drv->cache_slots = 0;
+        return;
+    }
+    drv->cache_slot = lib_malloc(drv->cache_slots * sizeof(ata_cache_slot_t));
+    drv->cache_data = lib_malloc((size_t)drv->cache_slots * drv->sector_size);
+    for (i = 0; i < drv->cache_slots; i++) {
+        drv->cache_slot[i].lba = -1;
+        drv->cache_slot[i].dirty = 0;
+    }
+}
+
+static void ata_cache_free(ata_drive_t *drv)
+{
+    if (drv->cache_slots) {
+        lib_free(drv->cache_slot);
+        lib_free(drv->cache_data);
+        drv->cache_slot = NULL;
+        drv->cache_data = NULL;
+        drv->cache_slots = 0;
+    }
+}
+
+/* write back `count' dirty sectors of adjacent slots */
+static int ata_cache_write_back(ata_drive_t *drv, int slot, int count)
+{
+    int i, result = 0;
+
+    if (fseeko(drv->file, (off_t)drv->cache_slot[slot].lba * drv->sector_size, SEEK_SET)
+        || fwrite(drv->cache_data + (size_t)slot * drv->sector_size, drv->sector_size, count, drv->file) != (size_t)count) {
+        log_error(drv->log, "Cannot write sectors %d-%d to image.", drv->cache_slot[slot].lba, drv->cache_slot[slot].lba + count - 1);
+        result = -1;
+    }
+    for (i = 0; i < count; i++) {
+        drv->cache_slot[slot + i].dirty = 0;
+    }
+    return result;
+}
+
+static int ata_cache_flush(ata_drive_t *drv)
+{
+    int i, n, result = 0;
+
+    for (i = 0; i < drv->cache_slots; i += n) {
+        n = 1;
+        if (!drv->cache_slot[i].dirty) {
+            continue;
+        }
+        while (i + n < drv->cache_slots && drv->cache_slot[i + n].dirty
+               && drv->cache_slot[i + n].lba == drv->cache_slot[i].lba + n) {
+            n++;
+        }
+        if (ata_cache_write_back(drv, i, n)) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+/* write back the cache and flush the image */
+static int ata_flush(ata_drive_t *drv)
+{
+    int result = ata_cache_flush(drv);
+
+    if (fflush(drv->file)) {
+        result = -1;
+    }
+    return result;
+}
+
+static int ata_cache_read(ata_drive_t *drv)
+{
+    int slot = drv->pos % drv->cache_slots;
+    int i, count;
+    size_t n;
+
+    if (drv->cache_slot[slot].lba != drv->pos) {
+        count = drv->sector_count_internal ? drv->sector_count_internal : 256;
+        if (count < ATA_READ_AHEAD) {
+            count = ATA_READ_AHEAD;
+        }
+        if (count > drv->cache_slots - slot) {
+            count = drv->cache_slots - slot;
+        }
+        if (count > drv->geometry.size - drv->pos) {
+            count = drv->geometry.size - drv->pos;
+        }
+        for (i = 0; i < count; i++) {
+            if (drv->cache_slot[slot + i].dirty) {
+                ata_cache_flush(drv);
+                break;
+            }
+        }
+
+        clearerr(drv->file);
+        n = 0;
+        if (!fseeko(drv->file, (off_t)drv->pos * drv->sector_size, SEEK_SET)) {
+            n = fread(drv->cache_data + (size_t)slot * drv->sector_size, drv->sector_size, count, drv->file);
+        }
+        if (ferror(drv->file)) {
+            for (i = 0; i < count; i++) {
+                drv->cache_slot[slot + i].lba = -1;
+            }
+            return -1;
+        }
+        /* past the end of the image */
+        memset(drv->cache_data + (slot + n) * drv->sector_size, 0, (count - n) * drv->sector_size);
+        for (i = 0; i < count; i++) {
+            drv->cache_slot[slot + i].lba = drv->pos + i;
+        }
+    }
+    memcpy(drv->buffer, drv->cache_data + (size_t)slot * drv->sector_size, drv->sector_size);
+    return 0;
+}
+
+static int ata_cache_write(ata_drive_t *drv)
+{
+    int slot = drv->pos % drv->cache_slots;
+    int result = 0;
+
+    if (drv->cache_slot[slot].dirty && drv->cache_slot[slot].lba != drv->pos) {
+        result = ata_cache_flush(drv);
+    }
+    memcpy(drv->cache_data + (size_t)slot * drv->sector_size, drv->buffer, drv->sector_size);
+    drv->cache_slot[slot].lba = drv->pos;
+    drv->cache_slot[slot].dirty = 1;
+    return result;
+}
+
 static void debug_addr(ata_drive_t *drv, char *cmd)
 {
     if (drv->lbamode && drv->lba) {
@@ -287,8 +444,21 @@ static int read_sector(ata_drive_t *drv)
         return drv->error;
     }
 
+    if (drv->cache_slots) {
+        if (ata_cache_read(drv)) {
+            ata_set_command_block(drv);
+            drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
+            drv->cmd = 0x00;
+            return drv->error;
+        }
+        drv->pos++;
+        drv->bufp = 0;
+        return drv->error;
+    }
+
     clearerr(drv->file);
-    if (fread(drv->buffer, drv->sector_size, 1, drv->file) != 1) {
+    if (fseeko(drv->file, (off_t)drv->pos * drv->sector_size, SEEK_SET)
+        || fread(drv->buffer, drv->sector_size, 1, drv->file) != 1) {
         memset(drv->buffer, 0, drv->sector_size);
     }
 
@@ -329,7 +499,20 @@ static int write_sector(ata_drive_t *drv)
         return drv->error;
     }
 
-    if (fwrite(drv->buffer, 1, drv->sector_size, drv->file) != (size_t)drv->sector_size) {
+    if (drv->cache_slots) {
+        /* written back at the end of the command at the latest */
+        if (ata_cache_write(drv)) {
+            ata_set_command_block(drv);
+            drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
+            drv->cmd = 0x00;
+        } else {
+            drv->pos++;
+        }
+        return drv->error;
+    }
+
+    if (fseeko(drv->file, (off_t)drv->pos * drv->sector_size, SEEK_SET)
+        || fwrite(drv->buffer, 1, drv->sector_size, drv->file) != (size_t)drv->sector_size) {
         ata_set_command_block(drv);
         drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
         drv->cmd = 0x00;
@@ -544,6 +727,10 @@ ata_drive_t *ata_init(int drive)
     drv->file = NULL;
     drv->filename = NULL;
     drv->buffer = lib_malloc(2048);
+    drv->cache_size = 0;
+    drv->cache_slots = 0;
+    drv->cache_slot = NULL;
+    drv->cache_data = NULL;
     drv->slave = drive & 1;
     drv->cycles_1s = (CLOCK)1000000;
     ata_poweron(drv, ATA_DRIVE_NONE);
@@ -571,6 +758,7 @@ void ata_shutdown(ata_drive_t *drv)
     log_close(drv->log);
     lib_free(drv->myname);
     lib_free(drv->buffer);
+    ata_cache_free(drv);
     lib_free(drv);
 }
 
@@ -731,7 +919,7 @@ static void ata_execute_command(ata_drive_t *drv, uint8_t value)
             }
             debug((drv->log, "FLUSH CACHE"));
             if (drv->file) {
-                if (fflush(drv->file)) {
+                if (ata_flush(drv)) {
                     drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
                 }
             }
@@ -836,7 +1024,7 @@ static void ata_execute_command(ata_drive_t *drv, uint8_t value)
                     debug((drv->log, "SET DISABLE WRITE CACHE"));
                     drv->wcache = 0;
                     if (drv->file) {
-                        fflush(drv->file);
+                        ata_flush(drv);
                     }
                     return;
                 case 0x99:
@@ -1198,7 +1386,7 @@ void ata_register_store(ata_drive_t *drv, uint16_t addr, uint16_t value)
                                     drv->bufp = 0;
                                     return;
                                 }
-                                if (!drv->file || fflush(drv->file)) {
+                                if (!drv->file || (drv->wcache ? fflush(drv->file) : ata_flush(drv))) {
                                     drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
                                     break;
                                 }
@@ -1263,6 +1451,8 @@ void ata_register_store(ata_drive_t *drv, uint16_t addr, uint16_t value)
 void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, ata_drive_geometry_t geometry)
 {
     if (drv->file != NULL) {
+        ata_cache_flush(drv);
+        ata_cache_free(drv);
         fclose(drv->file);
         drv->file = NULL;
     }
@@ -1307,6 +1497,7 @@ void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, a
     }
 
     if (drv->file) {
+        ata_cache_alloc(drv);
         if (drv->atapi) {
             log_message(drv->log, "Attached `%s' %u sectors total.", drv->filename, drv->geometry.size);
         } else {
@@ -1323,6 +1514,8 @@ void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, a
 void ata_image_detach(ata_drive_t *drv)
 {
     if (drv->file != NULL) {
+        ata_cache_flush(drv);
+        ata_cache_free(drv);
         fclose(drv->file);
         drv->file = NULL;
         log_message(drv->log, "Detached.");
@@ -1330,6 +1523,19 @@ void ata_image_detach(ata_drive_t *drv)
     return;
 }
 
+/* set the size of the sector cache in KiB, 0 to disable it */
+void ata_set_cache_size(ata_drive_t *drv, int size)
+{
+    if (drv->file) {
+        ata_cache_flush(drv);
+        ata_cache_free(drv);
+    }
+    drv->cache_size = size;
+    if (drv->file) {
+        ata_cache_alloc(drv);
+    }
+}
+
 int ata_image_change(ata_drive_t *drv, char *filename, ata_drive_type_t type, ata_drive_geometry_t geometry)
 {
     if (drv->type != type || drv->locked) {
@@ -1392,10 +1598,9 @@ int ata_snapshot_write_module(ata_drive_t *drv, snapshot_t *s)
         standby_clk = drv->standby_alarm->context->pending_alarms[drv->standby_alarm->pending_idx].clk;
     }
     if (drv->file) {
-        pos = ftello(drv->file);
-        if (pos < 0) {
-            pos = 0;
-        }
+        /* the image has to match the snapshot */
+        ata_flush(drv);
+        pos = (off_t)drv->pos * drv->sector_size;
     }
 
     SMW_STR(m, drv->filename);
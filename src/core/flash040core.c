@@ -149,6 +149,12 @@ inline static void flash_add_sector_to_erase_mask(flash040_context_t *flash040_c
     flash040_context->erase_mask[sector_num >> 3] |= (uint8_t)(1 << (sector_num & 0x7));
 }
 
+inline static void flash_set_sector_dirty(flash040_context_t *flash040_context, unsigned int sector)
+{
+    flash040_context->dirty_mask[sector >> 3] |= (uint8_t)(1 << (sector & 0x7));
+    flash040_context->flash_dirty = 1;
+}
+
 inline static void flash_erase_sector(flash040_context_t *flash040_context, unsigned int sector)
 {
     unsigned int sector_size = flash_types[flash040_context->flash_type].sector_size;
@@ -158,13 +164,14 @@ inline static void flash_erase_sector(flash040_context_t *flash040_context, unsi
 
     FLASH_DEBUG(("Erasing 0x%x - 0x%x", sector_addr, sector_addr + sector_size - 1));
     memset(&(flash040_context->flash_data[sector_addr]), 0xff, sector_size);
-    flash040_context->flash_dirty = 1;
+    flash_set_sector_dirty(flash040_context, sector);
 }
 
 inline static void flash_erase_chip(flash040_context_t *flash040_context)
 {
     FLASH_DEBUG(("Erasing chip"));
     memset(flash040_context->flash_data, 0xff, flash_types[flash040_context->flash_type].size);
+    memset(flash040_context->dirty_mask, 0xff, FLASH040_DIRTY_MASK_SIZE);
     flash040_context->flash_dirty = 1;
 }
 
@@ -176,7 +183,7 @@ inline static int flash_program_byte(flash040_context_t *flash040_context, unsig
     FLASH_DEBUG(("Programming 0x%05x with 0x%02x (%02x->%02x)", addr, byte, old_data, old_data & byte));
     flash040_context->program_byte = byte;
     flash040_context->flash_data[addr] = new_data;
-    flash040_context->flash_dirty = 1;
+    flash_set_sector_dirty(flash040_context, flash_addr_to_sector_number(flash040_context, addr));
 
     return (new_data == byte) ? 1 : 0;
 }
@@ -466,6 +473,33 @@ uint8_t flash040core_peek(flash040_context_t *flash040_context, unsigned int add
     return flash040_context->flash_data[addr];
 }
 
+/* Returns non-zero if a sector overlapping `size' bytes at `addr' was
+   programmed or erased since the last `flash040core_clear_dirty()'.  */
+int flash040core_range_dirty(flash040_context_t *flash040_context, unsigned int addr, unsigned int size)
+{
+    unsigned int sector, last;
+
+    if (!flash040_context->flash_dirty || size == 0) {
+        return 0;
+    }
+
+    sector = flash_addr_to_sector_number(flash040_context, addr);
+    last = flash_addr_to_sector_number(flash040_context, addr + size - 1);
+
+    for (; sector <= last; sector++) {
+        if (flash040_context->dirty_mask[sector >> 3] & (1 << (sector & 0x7))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void flash040core_clear_dirty(flash040_context_t *flash040_context)
+{
+    memset(flash040_context->dirty_mask, 0, FLASH040_DIRTY_MASK_SIZE);
+    flash040_context->flash_dirty = 0;
+}
+
 void flash040core_reset(flash040_context_t *flash040_context)
 {
     FLASH_DEBUG(("Reset"));
@@ -487,7 +521,7 @@ void flash040core_init(struct flash040_context_s *flash040_context,
     flash040_context->flash_base_state = FLASH040_STATE_READ;
     flash040_context->program_byte = 0;
     flash_clear_erase_mask(flash040_context);
-    flash040_context->flash_dirty = 0;
+    flash040core_clear_dirty(flash040_context);
     flash040_context->erase_alarm = alarm_new(alarm_context, "Flash040Alarm", erase_alarm_handler, flash040_context);
 }
 
@@ -56,6 +56,9 @@ static FILE *m93c86_image_file = NULL;
 
 static uint8_t m93c86_data[M93C86_SIZE];
 
+/* the image has to be written back */
+static int m93c86_dirty = 0;
+
 static int eeprom_cs = 0;
 static int eeprom_clock = 0;
 static int eeprom_data_in = 0;
@@ -268,6 +271,7 @@ void m93c86_write_clock(uint8_t value)
                                 reset_input_shiftreg();
                                 m93c86_data[(addr << 1)] = 0xff;
                                 m93c86_data[(addr << 1) + 1] = 0xff;
+                                m93c86_dirty = 1;
                                 LOG(("CMD: erase addr %04x", addr));
                             }
                             break;
@@ -280,6 +284,7 @@ void m93c86_write_clock(uint8_t value)
                                 ready_busy_status = STATUSBUSY;
                                 reset_input_shiftreg();
                                 memset(m93c86_data, 0xff, M93C86_SIZE);
+                                m93c86_dirty = 1;
                                 LOG(("CMD: erase all"));
                             }
                             break;
@@ -300,6 +305,7 @@ void m93c86_write_clock(uint8_t value)
                                 reset_input_shiftreg();
                                 m93c86_data[(addr << 1)] = data0;
                                 m93c86_data[(addr << 1) + 1] = data1;
+                                m93c86_dirty = 1;
                                 LOG(("CMD: write addr %04x %02x %02x", addr, data0, data1));
                             }
                             break;
@@ -317,6 +323,7 @@ void m93c86_write_clock(uint8_t value)
                                     m93c86_data[(addr << 1)] = data0;
                                     m93c86_data[(addr << 1) + 1] = data1;
                                 }
+                                m93c86_dirty = 1;
                                 LOG(("CMD: write all %02x %02x", data0, data1));
                             }
                             break;
@@ -344,6 +351,8 @@ int m93c86_open_image(char *name, int rw)
         m93c86_close_image(rw);
     }
 
+    m93c86_dirty = 0;
+
     if (rw) {
         m93c86_image_file = fopen(m93c86_image_filename, "rb+");
     }
@@ -375,7 +384,7 @@ void m93c86_close_image(int rw)
 {
     /* unmount EEPROM image */
     if (m93c86_image_file != NULL) {
-        if (rw) {
+        if (rw && m93c86_dirty) {
             fseek(m93c86_image_file, 0, SEEK_SET);
             if (fwrite(m93c86_data, 1, M93C86_SIZE, m93c86_image_file) == 0) {
                 log_debug("could not write eeprom card image");
@@ -95,6 +95,8 @@ static int mmc_card_rw = 0;
 
 /* Image file */
 static FILE *mmc_image_file = NULL;
+static int mmc_image_file_readonly = 0;
+static sd_addr_t mmc_image_size;
 
 /* Pointer inside image */
 static sd_addr_t mmc_image_pointer;
@@ -102,6 +104,10 @@ static sd_addr_t mmc_image_pointer;
 /* write sequence counter */
 static unsigned int mmc_write_sequence;
 
+/* Address and data of the block being written */
+static sd_addr_t mmc_write_address;
+static uint8_t mmc_write_buffer[0x1000];
+
 static uint8_t mmc_card_inserted;
 static uint8_t mmc_card_state;
 static uint8_t mmc_card_reset_count;
@@ -169,6 +175,206 @@ static uint8_t mmc_read_buffer_getbyte(void)
     return value;
 }
 
+/* Image block cache
+
+   The image is accessed through a small cache of 512 byte lines, so a block
+   read is a copy instead of a seek and a read of the file, and a written
+   block stays in the cache until its line is evicted (least recently used
+   first), the image is closed or a snapshot is written.  A miss right after
+   the end of the previous read also reads the following lines, as the
+   directory and file accesses of the card drivers are mostly sequential.
+*/
+
+#define MMC_CACHE_LINE_SIZE   512
+#define MMC_CACHE_LINES       64
+#define MMC_CACHE_READ_AHEAD  8
+
+typedef struct mmc_cache_line_s {
+    int valid;
+    int dirty;
+    sd_addr_t addr;         /* image offset of the line */
+    unsigned int len;       /* bytes of the line that exist in the image */
+    unsigned int stamp;     /* for finding the least recently used line */
+    uint8_t data[MMC_CACHE_LINE_SIZE];
+} mmc_cache_line_t;
+
+static mmc_cache_line_t mmc_cache[MMC_CACHE_LINES];
+static unsigned int mmc_cache_stamp;
+static sd_addr_t mmc_cache_next_read;
+static uint8_t mmc_cache_read_ahead_buffer[MMC_CACHE_LINE_SIZE * MMC_CACHE_READ_AHEAD];
+
+static void mmc_cache_flush_line(mmc_cache_line_t *line)
+{
+    if (line->valid && line->dirty) {
+        if (util_fpwrite(mmc_image_file, line->data, line->len, (long)line->addr) < 0) {
+            LOG(("could not write to mmc image file"));
+            /* FIXME: handle error */
+        }
+        line->dirty = 0;
+    }
+}
+
+static void mmc_cache_flush(void)
+{
+    int i;
+
+    for (i = 0; i < MMC_CACHE_LINES; i++) {
+        mmc_cache_flush_line(&mmc_cache[i]);
+    }
+    if (mmc_image_file != NULL) {
+        fflush(mmc_image_file);
+    }
+}
+
+static void mmc_cache_invalidate(void)
+{
+    int i;
+
+    for (i = 0; i < MMC_CACHE_LINES; i++) {
+        mmc_cache[i].valid = 0;
+        mmc_cache[i].dirty = 0;
+    }
+    mmc_cache_next_read = 0;
+}
+
+static mmc_cache_line_t *mmc_cache_find(sd_addr_t addr)
+{
+    int i;
+
+    for (i = 0; i < MMC_CACHE_LINES; i++) {
+        if (mmc_cache[i].valid && mmc_cache[i].addr == addr) {
+            mmc_cache[i].stamp = ++mmc_cache_stamp;
+            return &mmc_cache[i];
+        }
+    }
+    return NULL;
+}
+
+/* Get an unused or the least recently used line for `addr', with its old
+   contents written back.  */
+static mmc_cache_line_t *mmc_cache_alloc(sd_addr_t addr)
+{
+    mmc_cache_line_t *line = &mmc_cache[0];
+    int i;
+
+    for (i = 0; i < MMC_CACHE_LINES && line->valid; i++) {
+        if (!mmc_cache[i].valid || mmc_cache[i].stamp < line->stamp) {
+            line = &mmc_cache[i];
+        }
+    }
+    mmc_cache_flush_line(line);
+
+    line->valid = 1;
+    line->dirty = 0;
+    line->addr = addr;
+    line->len = 0;
+    line->stamp = ++mmc_cache_stamp;
+    return line;
+}
+
+/* Read `count' lines starting at `addr' with a single access of the image,
+   and return the first one.  Lines that are already cached are kept.  */
+static mmc_cache_line_t *mmc_cache_load(sd_addr_t addr, unsigned int count)
+{
+    mmc_cache_line_t *line;
+    mmc_cache_line_t *first = NULL;
+    size_t len = 0;
+    size_t offset;
+    unsigned int i;
+
+    if (fseek(mmc_image_file, (long)addr, SEEK_SET) == 0) {
+        len = fread(mmc_cache_read_ahead_buffer, 1, count * MMC_CACHE_LINE_SIZE, mmc_image_file);
+    }
+
+    for (i = 0; i < count; i++) {
+        offset = i * MMC_CACHE_LINE_SIZE;
+        line = mmc_cache_find(addr + offset);
+        if (line == NULL) {
+            line = mmc_cache_alloc(addr + offset);
+            if (len > offset) {
+                line->len = (unsigned int)(len - offset < MMC_CACHE_LINE_SIZE ? len - offset : MMC_CACHE_LINE_SIZE);
+                memcpy(line->data, mmc_cache_read_ahead_buffer + offset, line->len);
+            }
+            memset(line->data + line->len, 0, MMC_CACHE_LINE_SIZE - line->len);
+        }
+        if (first == NULL) {
+            first = line;
+        }
+    }
+    return first;
+}
+
+/* Read from the image like fread(), returns the number of bytes that exist
+   in the image.  */
+static size_t mmc_cache_read(sd_addr_t addr, uint8_t *buf, size_t size)
+{
+    mmc_cache_line_t *line;
+    sd_addr_t line_addr;
+    size_t offset, len;
+    size_t done = 0;
+
+    if (addr >= mmc_image_size) {
+        return 0;
+    }
+
+    while (done < size) {
+        line_addr = (addr + done) - ((addr + done) % MMC_CACHE_LINE_SIZE);
+        offset = (size_t)((addr + done) - line_addr);
+        len = MMC_CACHE_LINE_SIZE - offset;
+        if (len > size - done) {
+            len = size - done;
+        }
+
+        line = mmc_cache_find(line_addr);
+        if (line == NULL) {
+            line = mmc_cache_load(line_addr, (addr == mmc_cache_next_read) ? MMC_CACHE_READ_AHEAD : 1);
+        }
+        memcpy(buf + done, line->data + offset, len);
+        done += len;
+    }
+    mmc_cache_next_read = addr + size;
+
+    return (mmc_image_size - addr < size) ? (size_t)(mmc_image_size - addr) : size;
+}
+
+/* Write to the image through the cache.  */
+static void mmc_cache_write(sd_addr_t addr, const uint8_t *buf, size_t size)
+{
+    mmc_cache_line_t *line;
+    sd_addr_t line_addr;
+    size_t offset, len;
+    size_t done = 0;
+
+    while (done < size) {
+        line_addr = (addr + done) - ((addr + done) % MMC_CACHE_LINE_SIZE);
+        offset = (size_t)((addr + done) - line_addr);
+        len = MMC_CACHE_LINE_SIZE - offset;
+        if (len > size - done) {
+            len = size - done;
+        }
+
+        line = mmc_cache_find(line_addr);
+        if (line == NULL) {
+            if (len == MMC_CACHE_LINE_SIZE) {
+                /* the whole line is overwritten, no need to read it */
+                line = mmc_cache_alloc(line_addr);
+            } else {
+                line = mmc_cache_load(line_addr, 1);
+            }
+        }
+        memcpy(line->data + offset, buf + done, len);
+        if (line->len < offset + len) {
+            line->len = (unsigned int)(offset + len);
+        }
+        line->dirty = 1;
+        done += len;
+    }
+
+    if (mmc_image_size < addr + size) {
+        mmc_image_size = addr + size;
+    }
+}
+
 /* Resets the card */
 static void mmc_reset_card(void)
 {
@@ -638,25 +844,20 @@ static void mmc_execute_cmd(void)
 #ifdef DEBUG_MMC
                     log_debug("Address: %08x", mmc_current_address_pointer);
 #endif
-                    if (fseek(mmc_image_file, mmc_current_address_pointer, SEEK_SET) != 0) {
-                        mmc_card_state = MMC_CARD_DUMMY_READ;
-                    } else {
+                    {
                         uint8_t readbuf[0x1000];    /* FIXME */
 #ifdef DEBUG_MMC
                         log_debug("Buffering: %08x", mmc_current_address_pointer);
 #endif
-                        fseek(mmc_image_file, mmc_current_address_pointer, SEEK_SET);
-                        if (!feof(mmc_image_file)) {
-                            if (fread(readbuf, 1, mmc_block_size, mmc_image_file) > 0) {
-                                mmc_read_buffer_readptr = 0;
-                                mmc_read_buffer_writeptr = 0;
-                                mmc_read_buffer_set(readbuf, mmc_block_size);
+                        if (mmc_cache_read(mmc_current_address_pointer, readbuf, mmc_block_size) > 0) {
+                            mmc_read_buffer_readptr = 0;
+                            mmc_read_buffer_writeptr = 0;
+                            mmc_read_buffer_set(readbuf, mmc_block_size);
 #ifdef DEBUG_MMC
-                                log_debug("Buffered: %02x %02x", readbuf[0], readbuf[1]);
+                            log_debug("Buffered: %02x %02x", readbuf[0], readbuf[1]);
 #endif
-                            } else {
-                                /* FIXME: handle error */
-                            }
+                        } else {
+                            /* FIXME: handle error */
                         }
                     }
                 }
@@ -681,6 +882,7 @@ static void mmc_execute_cmd(void)
 #endif
                 } else {
                     mmc_write_sequence = 0;
+                    mmc_write_address = mmc_current_address_pointer;
                     mmc_card_state = MMC_CARD_WRITE;
                 }
             } else {
@@ -801,14 +1003,20 @@ static void mmc_write_to_mmc(uint8_t value)
             }
             break;
         case 1:
-            if (mmc_card_state == MMC_CARD_WRITE) {
-                if (fwrite(&value, 1, 1, mmc_image_file) != 1) {
-                    LOG(("could not write to mmc image file"));
-                    /* FIXME: handle error */
-                }
+            if (mmc_image_pointer < sizeof(mmc_write_buffer)) {
+                mmc_write_buffer[mmc_image_pointer] = value;
             }
             mmc_image_pointer++;
             if (mmc_image_pointer == mmc_block_size) {
+                /* the whole block goes to the image at once */
+                if (mmc_card_state == MMC_CARD_WRITE) {
+                    if (mmc_image_file_readonly) {
+                        LOG(("could not write to mmc image file"));
+                    } else {
+                        mmc_cache_write(mmc_write_address, mmc_write_buffer,
+                                        mmc_block_size < sizeof(mmc_write_buffer) ? mmc_block_size : sizeof(mmc_write_buffer));
+                    }
+                }
                 mmc_write_sequence++;
             }
             break;
@@ -863,23 +1071,35 @@ int mmc_open_card_image(char *name, int rw)
             /* FIXME */
             spi_mmc_set_card_inserted(MMC_CARD_INSERTED);
             LOG(("opened sd card image (ro): %s", mmc_image_filename));
-            /* mmc_image_file_readonly = 1; */
+            mmc_image_file_readonly = 1;
             /* mmcreplay_hw_writeprotect = 1; */
             /* mmcreplay_writeprotect = MMC_WRITEPROT; */
         }
     } else {
-        /* mmc_image_file_readonly = 0; */
+        mmc_image_file_readonly = 0;
         spi_mmc_set_card_inserted(MMC_CARD_INSERTED);
         LOG(("opened sd card image (rw): %s", mmc_image_filename));
     }
     mmc_card_rw = rw;
+    mmc_image_size = (sd_addr_t)util_file_length(mmc_image_file);
+    mmc_cache_invalidate();
     return 0;
 }
 
+/* Write the cached blocks back to the image */
+void mmc_flush_card_image(void)
+{
+    if (mmc_image_file != NULL) {
+        mmc_cache_flush();
+    }
+}
+
 void mmc_close_card_image(void)
 {
     /* unmount mmc cart image */
     if (mmc_image_file != NULL) {
+        mmc_cache_flush();
+        mmc_cache_invalidate();
         fclose(mmc_image_file);
         mmc_image_file = NULL;
         spi_mmc_set_card_inserted(MMC_CARD_NOTINSERTED);
@@ -896,6 +1116,8 @@ void mmc_close_card_image(void)
 /* FIXME: implement snapshot support */
 int mmc_snapshot_write_module(snapshot_t *s)
 {
+    /* the image itself is not part of the snapshot, but it has to match it */
+    mmc_flush_card_image();
     return -1;
 #if 0
     snapshot_module_t *m;
@@ -47,6 +47,7 @@ extern uint8_t spi_mmc_data_read(void);
 extern void spi_mmc_data_write(uint8_t value);
 extern int  mmc_open_card_image(char *name, int rw);
 extern void mmc_close_card_image(void);
+extern void mmc_flush_card_image(void);
 extern uint8_t mmc_set_card_type(uint8_t value);
 
 struct snapshot_s;
@@ -681,6 +681,22 @@ int disk_image_read_image(const disk_image_t *image)
     }
 }
 
+/* Convert a track of a sector based image to GCR.  Tracks of these images
+   are only converted when needed, they are left with `data' set to NULL
+   and the final `size' by `disk_image_read_image()'.  */
+int disk_image_read_half_track(const disk_image_t *image, unsigned int half_track,
+                               struct disk_track_s *raw)
+{
+    switch (image->type) {
+        case DISK_IMAGE_TYPE_P64:
+        case DISK_IMAGE_TYPE_G64:
+        case DISK_IMAGE_TYPE_G71:
+            return -1;
+        default:
+            return fsimage_dxx_read_half_track(image, half_track, raw);
+    }
+}
+
 int disk_image_write_p64_image(const disk_image_t *image)
 {
     return fsimage_write_p64_image(image);
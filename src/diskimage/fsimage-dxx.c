@@ -106,7 +106,7 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
         offset += X64_HEADER_LENGTH;
     }
 
-    if (util_fpwrite(fsimage->fd, buffer, max_sector * 256, offset) < 0) {
+    if (fsimage_fpwrite(fsimage, buffer, max_sector * 256, offset) < 0) {
         log_error(fsimage_dxx_log, "Error writing T:%i to disk image.",
                   track);
         lib_free(buffer);
@@ -123,10 +123,10 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
 
             fsimage->error_info.dirty = 0;
             if (error_info_created) {
-                res = util_fpwrite(fsimage->fd, fsimage->error_info.map,
+                res = fsimage_fpwrite(fsimage, fsimage->error_info.map,
                                    fsimage->error_info.len, fsimage->error_info.len * 256);
             } else {
-                res = util_fpwrite(fsimage->fd, fsimage->error_info.map + sectors,
+                res = fsimage_fpwrite(fsimage, fsimage->error_info.map + sectors,
                                    max_sector, offset);
             }
             if (res < 0) {
@@ -142,20 +142,17 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
     return 0;
 }
 
+/* Only the disk IDs are read from the image here, the tracks themselves
+   are converted to GCR by `fsimage_dxx_read_half_track()' when the drive
+   head gets there.  Until then a track has no data but already has its
+   final size.  */
 int fsimage_read_dxx_image(const disk_image_t *image)
 {
     uint8_t buffer[256], *bam_id;
-    int gap;
-    unsigned int track, sector, track_size;
-    gcr_header_t header;
-    fdc_err_t rf;
-    int double_sided = 0;
+    unsigned int track;
     fsimage_t *fsimage = image->media.fsimage;
-    unsigned int max_sector;
-    uint8_t *ptr;
     int half_track;
     int sectors;
-    long offset;
 
     if (image->type == DISK_IMAGE_TYPE_D80
         || image->type == DISK_IMAGE_TYPE_D82) {
@@ -168,78 +165,118 @@ int fsimage_read_dxx_image(const disk_image_t *image)
 
     bam_id[0] = bam_id[1] = 0xa0;
     if (sectors >= 0) {
-        util_fpread(fsimage->fd, buffer, 256, sectors << 8);
+        fsimage_fpread(fsimage, buffer, 256, sectors << 8);
     }
-    header.id1 = bam_id[0];
-    header.id2 = bam_id[1];
+    fsimage->gcr_info.id[0][0] = bam_id[0];
+    fsimage->gcr_info.id[0][1] = bam_id[1];
 
     /* check double sided images */
-    double_sided = (image->type == DISK_IMAGE_TYPE_D71) && !(buffer[0x03] & 0x80);
+    fsimage->gcr_info.double_sided = (image->type == DISK_IMAGE_TYPE_D71) && !(buffer[0x03] & 0x80);
+
+    if (fsimage->gcr_info.double_sided && image->tracks >= 36) {
+        sectors = disk_image_check_sector(image, BAM_TRACK_1571 + 35, BAM_SECTOR_1571);
 
-    for (header.track = track = 1; track <= image->max_half_tracks / 2; track++, header.track++) {
+        buffer[BAM_ID_1571] = buffer[BAM_ID_1571 + 1] = 0xa0;
+        if (sectors >= 0) {
+            fsimage_fpread(fsimage, buffer, 256, sectors << 8);
+        }
+        fsimage->gcr_info.id[1][0] = buffer[BAM_ID_1571]; /* second side */
+        fsimage->gcr_info.id[1][1] = buffer[BAM_ID_1571 + 1];
+    }
+
+    for (track = 1; track <= image->max_half_tracks / 2; track++) {
         half_track = track * 2 - 2;
 
-        track_size = disk_image_raw_track_size(image->type, track);
-        if (image->gcr->tracks[half_track].data == NULL) {
-            image->gcr->tracks[half_track].data = lib_malloc(track_size);
-        } else if (image->gcr->tracks[half_track].size != (int)track_size) {
-            image->gcr->tracks[half_track].data = lib_realloc(image->gcr->tracks[half_track].data, track_size);
+        if (image->gcr->tracks[half_track].data) {
+            lib_free(image->gcr->tracks[half_track].data);
+            image->gcr->tracks[half_track].data = NULL;
         }
-        ptr = image->gcr->tracks[half_track].data;
-        image->gcr->tracks[half_track].size = track_size;
+        image->gcr->tracks[half_track].size = disk_image_raw_track_size(image->type, track);
 
-        if (track <= image->tracks) {
-            if (double_sided && track == 36) {
-                sectors = disk_image_check_sector(image, BAM_TRACK_1571 + 35, BAM_SECTOR_1571);
+        /* Clear odd track */
+        half_track++;
+        if (image->gcr->tracks[half_track].data) {
+            lib_free(image->gcr->tracks[half_track].data);
+            image->gcr->tracks[half_track].data = NULL;
+        }
+        image->gcr->tracks[half_track].size = 0;
+    }
+    return 0;
+}
 
-                buffer[BAM_ID_1571] = buffer[BAM_ID_1571 + 1] = 0xa0;
-                if (sectors >= 0) {
-                    util_fpread(fsimage->fd, buffer, 256, sectors << 8);
-                }
-                header.id1 = buffer[BAM_ID_1571]; /* second side, update id and track */
-                header.id2 = buffer[BAM_ID_1571 + 1];
-                header.track = 1;
-            }
+int fsimage_dxx_read_half_track(const disk_image_t *image, unsigned int half_track,
+                                disk_track_t *raw)
+{
+    uint8_t buffer[256];
+    int gap;
+    unsigned int track, sector, track_size;
+    gcr_header_t header;
+    fdc_err_t rf;
+    fsimage_t *fsimage = image->media.fsimage;
+    unsigned int max_sector;
+    uint8_t *ptr;
+    const uint8_t *data;
+    int sectors;
+    long offset;
 
-            gap = disk_image_gap_size(image->type, track);
+    track = half_track / 2;
 
-            max_sector = disk_image_sector_per_track(image->type, track);
+    if ((half_track & 1) || track < 1 || track > image->max_half_tracks / 2) {
+        return -1;
+    }
 
-            /* Clear track to avoid read errors.  */
-            memset(ptr, 0x55, track_size);
+    track_size = disk_image_raw_track_size(image->type, track);
+    if (raw->data == NULL) {
+        raw->data = lib_malloc(track_size);
+    } else if (raw->size != (int)track_size) {
+        raw->data = lib_realloc(raw->data, track_size);
+    }
+    ptr = raw->data;
+    raw->size = track_size;
 
-            for (sector = 0; sector < max_sector; sector++) {
-                sectors = disk_image_check_sector(image, track, sector);
-                offset = sectors * 256;
+    /* Clear track to avoid read errors.  */
+    memset(ptr, 0x55, track_size);
 
-                if (image->type == DISK_IMAGE_TYPE_X64) {
-                    offset += X64_HEADER_LENGTH;
-                }
+    if (track > image->tracks) {
+        return 0;
+    }
 
-                if (sectors >= 0) {
-                    rf = CBMDOS_FDC_ERR_DRIVE;
-                    if (util_fpread(fsimage->fd, buffer, 256, offset) >= 0) {
-                        if (fsimage->error_info.map != NULL) {
-                            rf = fsimage->error_info.map[sectors];
-                        }
-                    }
-                    header.sector = sector;
-                    gcr_convert_sector_to_GCR(buffer, ptr, &header, 9, 5, rf);
-                }
+    if (fsimage->gcr_info.double_sided && track >= 36) {
+        header.id1 = fsimage->gcr_info.id[1][0];
+        header.id2 = fsimage->gcr_info.id[1][1];
+        header.track = track - 35;
+    } else {
+        header.id1 = fsimage->gcr_info.id[0][0];
+        header.id2 = fsimage->gcr_info.id[0][1];
+        header.track = track;
+    }
 
-                ptr += SECTOR_GCR_SIZE_WITH_HEADER + 9 + gap + 5;
-            }
-        } else {
-            memset(ptr, 0x55, track_size);
+    gap = disk_image_gap_size(image->type, track);
+
+    max_sector = disk_image_sector_per_track(image->type, track);
+
+    for (sector = 0; sector < max_sector; sector++) {
+        sectors = disk_image_check_sector(image, track, sector);
+        offset = sectors * 256;
+
+        if (image->type == DISK_IMAGE_TYPE_X64) {
+            offset += X64_HEADER_LENGTH;
         }
 
-        /* Clear odd track */
-        half_track++;
-        if (image->gcr->tracks[half_track].data) {
-            lib_free(image->gcr->tracks[half_track].data);
-            image->gcr->tracks[half_track].data = NULL;
-            image->gcr->tracks[half_track].size = 0;
+        if (sectors >= 0) {
+            /* convert straight from the mapped image if possible */
+            data = fsimage_map_get(fsimage, 256, offset);
+            rf = CBMDOS_FDC_ERR_DRIVE;
+            if (data != NULL || fsimage_fpread(fsimage, buffer, 256, offset) >= 0) {
+                if (fsimage->error_info.map != NULL) {
+                    rf = fsimage->error_info.map[sectors];
+                }
+            }
+            header.sector = sector;
+            gcr_convert_sector_to_GCR(data ? data : buffer, ptr, &header, 9, 5, rf);
         }
+
+        ptr += SECTOR_GCR_SIZE_WITH_HEADER + 9 + gap + 5;
     }
     return 0;
 }
@@ -265,8 +302,9 @@ int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
         offset += X64_HEADER_LENGTH;
     }
 
-    if (image->gcr == NULL) {
-        if (util_fpread(fsimage->fd, buf, 256, offset) < 0) {
+    /* tracks that were not converted to GCR yet are read from the file */
+    if (image->gcr == NULL || image->gcr->tracks[(dadr->track * 2) - 2].data == NULL) {
+        if (fsimage_fpread(fsimage, buf, 256, offset) < 0) {
             log_error(fsimage_dxx_log,
                       "Error reading T:%i S:%i from disk image.",
                       dadr->track, dadr->sector);
@@ -329,12 +367,12 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
         offset += X64_HEADER_LENGTH;
     }
 
-    if (util_fpwrite(fsimage->fd, buf, 256, offset) < 0) {
+    if (fsimage_fpwrite(fsimage, buf, 256, offset) < 0) {
         log_error(fsimage_dxx_log, "Error writing T:%i S:%i to disk image.",
                   dadr->track, dadr->sector);
         return -1;
     }
-    if (image->gcr != NULL) {
+    if (image->gcr != NULL && image->gcr->tracks[(dadr->track * 2) - 2].data != NULL) {
         gcr_write_sector(&image->gcr->tracks[(dadr->track * 2) - 2], buf, (uint8_t)dadr->sector);
     }
 
@@ -347,7 +385,7 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
         }
 
         fsimage->error_info.map[sectors] = CBMDOS_FDC_ERR_OK;
-        if (util_fpwrite(fsimage->fd, &fsimage->error_info.map[sectors], 1, offset) < 0) {
+        if (fsimage_fpwrite(fsimage, &fsimage->error_info.map[sectors], 1, offset) < 0) {
             log_error(fsimage_dxx_log, "Error writing T:%i S:%i error info to disk image.",
                       dadr->track, dadr->sector);
         }
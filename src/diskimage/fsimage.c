@@ -28,6 +28,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define FSIMAGE_USE_MMAP
+#endif
 
 #include "archdep.h"
 #include "diskconstants.h"
@@ -122,6 +129,127 @@ void fsimage_media_destroy(disk_image_t *image)
 
 /*-----------------------------------------------------------------------*/
 
+/* Sector based images are mapped into memory, so that the many small
+   sector reads and writes done by the virtual drive and c1541 are plain
+   memory copies instead of a seek and a read or write each.  Modified pages
+   are handed to the OS for writing with MS_ASYNC and synced when the image
+   is closed.  Without mmap(), or if it fails, `fd' is used as before.  */
+
+static void fsimage_map_open(disk_image_t *image)
+{
+#ifdef FSIMAGE_USE_MMAP
+    fsimage_t *fsimage = image->media.fsimage;
+    struct stat st;
+    void *data;
+    int prot = PROT_READ;
+
+    switch (image->type) {
+        case DISK_IMAGE_TYPE_D64:
+        case DISK_IMAGE_TYPE_D67:
+        case DISK_IMAGE_TYPE_D71:
+        case DISK_IMAGE_TYPE_D81:
+        case DISK_IMAGE_TYPE_D80:
+        case DISK_IMAGE_TYPE_D82:
+        case DISK_IMAGE_TYPE_X64:
+        case DISK_IMAGE_TYPE_D1M:
+        case DISK_IMAGE_TYPE_D2M:
+        case DISK_IMAGE_TYPE_D4M:
+            break;
+        default:
+            return;
+    }
+
+    if (fflush(fsimage->fd) != 0
+        || fstat(fileno(fsimage->fd), &st) < 0 || st.st_size <= 0) {
+        return;
+    }
+
+    if (!image->read_only) {
+        prot |= PROT_WRITE;
+    }
+    data = mmap(NULL, (size_t)st.st_size, prot, MAP_SHARED, fileno(fsimage->fd), 0);
+    if (data == MAP_FAILED) {
+        return;
+    }
+    fsimage->map.data = data;
+    fsimage->map.len = (size_t)st.st_size;
+    fsimage->map.writable = !image->read_only;
+    fsimage->map.dirty = 0;
+#endif
+}
+
+static void fsimage_map_close(fsimage_t *fsimage)
+{
+#ifdef FSIMAGE_USE_MMAP
+    if (fsimage->map.data == NULL) {
+        return;
+    }
+    if (fsimage->map.dirty) {
+        if (msync(fsimage->map.data, fsimage->map.len, MS_SYNC) < 0) {
+            log_error(fsimage_log, "Cannot write back `%s'.", fsimage->name);
+        }
+    }
+    munmap(fsimage->map.data, fsimage->map.len);
+#endif
+    fsimage->map.data = NULL;
+    fsimage->map.len = 0;
+    fsimage->map.dirty = 0;
+}
+
+/* Return a pointer to `num' bytes at `offset' if they are all mapped.  */
+const uint8_t *fsimage_map_get(const fsimage_t *fsimage, size_t num, long offset)
+{
+    if (fsimage->map.data == NULL || offset < 0
+        || (size_t)offset + num > fsimage->map.len) {
+        return NULL;
+    }
+    return fsimage->map.data + offset;
+}
+
+/* Like `util_fpread()', but using the mapped image where possible.  */
+int fsimage_fpread(const fsimage_t *fsimage, void *buf, size_t num, long offset)
+{
+    size_t part;
+
+    if (fsimage->map.data == NULL || offset < 0 || (size_t)offset >= fsimage->map.len) {
+        return util_fpread(fsimage->fd, buf, num, offset);
+    }
+
+    part = fsimage->map.len - (size_t)offset;
+    if (part >= num) {
+        memcpy(buf, fsimage->map.data + offset, num);
+        return 0;
+    }
+    /* the file was extended after mapping it */
+    memcpy(buf, fsimage->map.data + offset, part);
+    return util_fpread(fsimage->fd, (uint8_t *)buf + part, num - part, offset + (long)part);
+}
+
+/* Like `util_fpwrite()', but using the mapped image where possible.  */
+int fsimage_fpwrite(fsimage_t *fsimage, const void *buf, size_t num, long offset)
+{
+    size_t part;
+
+    if (fsimage->map.data == NULL || !fsimage->map.writable
+        || offset < 0 || (size_t)offset >= fsimage->map.len) {
+        return util_fpwrite(fsimage->fd, buf, num, offset);
+    }
+
+    part = fsimage->map.len - (size_t)offset;
+    if (part > num) {
+        part = num;
+    }
+    memcpy(fsimage->map.data + offset, buf, part);
+    /* written back by fsimage_map_close() */
+    fsimage->map.dirty = 1;
+    if (part < num) {
+        return util_fpwrite(fsimage->fd, (const uint8_t *)buf + part, num - part, offset + (long)part);
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+
 int fsimage_open(disk_image_t *image)
 {
     fsimage_t *fsimage;
@@ -147,6 +275,7 @@ int fsimage_open(disk_image_t *image)
     }
 
     if (fsimage_probe(image) == 0) {
+        fsimage_map_open(image);
         return 0;
     }
 
@@ -174,6 +303,7 @@ int fsimage_close(disk_image_t *image)
         lib_free(fsimage->error_info.map);
         fsimage->error_info.map = NULL;
     }
+    fsimage_map_close(fsimage);
     zfile_fclose(fsimage->fd);
     fsimage->fd = NULL;
 
@@ -42,6 +42,21 @@ typedef struct fsimage_s {
         int dirty;
         int len;
     } error_info;
+    /* Disk IDs for the sector headers when converting the tracks of
+       sector based images to GCR, the second pair is for the second side
+       of double sided D71 images.  */
+    struct {
+        uint8_t id[2][2];
+        int double_sided;
+    } gcr_info;
+    /* Sector based images mapped into memory, accesses within the mapped
+       part bypass `fd'.  */
+    struct {
+        uint8_t *data;
+        size_t len;
+        int writable;
+        int dirty;
+    } map;
 } fsimage_t;
 
 
@@ -55,6 +70,10 @@ extern void fsimage_media_destroy(struct disk_image_s *image);
 
 extern int fsimage_open(struct disk_image_s *image);
 extern int fsimage_close(struct disk_image_s *image);
+extern const uint8_t *fsimage_map_get(const fsimage_t *fsimage, size_t num, long offset);
+extern int fsimage_fpread(const fsimage_t *fsimage, void *buf, size_t num, long offset);
+extern int fsimage_fpwrite(fsimage_t *fsimage, const void *buf, size_t num, long offset);
+
 extern int fsimage_read_sector(const struct disk_image_s *image, uint8_t *buf,
                                const struct disk_addr_s *dadr);
 extern int fsimage_write_sector(struct disk_image_s *image, const uint8_t *buf,
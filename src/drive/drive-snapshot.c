@@ -935,12 +935,29 @@ static int drive_snapshot_write_gcrimage_module(snapshot_t *s, unsigned int dnr)
 
     /* Write half track data */
     for (i = 0; i < num_half_tracks; i++) {
+        int converted = 0;
+        int rc;
+
+        /* tracks of sector based images not converted to GCR yet, they are
+           dropped again afterwards so the track cache stays the only owner
+           of converted tracks */
+        if (drive->gcr->tracks[i].data == NULL && drive->gcr->tracks[i].size != 0
+            && drive->image != NULL) {
+            disk_image_read_half_track(drive->image, i + 2, &drive->gcr->tracks[i]);
+            converted = 1;
+        }
         data = drive->gcr->tracks[i].data;
         track_size = data ? drive->gcr->tracks[i].size : 0;
-        if (0
-            || SMW_DW(m, (uint32_t)track_size) < 0
-            || (track_size && SMW_BA(m, data, track_size) < 0)
-            ) {
+        rc = (0
+              || SMW_DW(m, (uint32_t)track_size) < 0
+              || (track_size && SMW_BA(m, data, track_size) < 0)
+              );
+        if (converted && data != NULL) {
+            /* keep the size, the track gets converted again when needed */
+            lib_free(drive->gcr->tracks[i].data);
+            drive->gcr->tracks[i].data = NULL;
+        }
+        if (rc) {
             break;
         }
     }
@@ -1020,11 +1037,12 @@ static int drive_snapshot_read_gcrimage_module(snapshot_t *s, unsigned int dnr)
         if (drive->gcr->tracks[i].data) {
             lib_free(drive->gcr->tracks[i].data);
             drive->gcr->tracks[i].data = NULL;
-            drive->gcr->tracks[i].size = 0;
         }
+        drive->gcr->tracks[i].size = 0;
     }
     snapshot_module_close(m);
 
+    drive->GCR_track_cache_num = 0;
     drive->GCR_image_loaded = 1;
     drive->complicated_image_loaded = 1; /* TODO: verify if it's really like this */
     drive->image = NULL;
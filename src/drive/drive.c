@@ -211,6 +211,7 @@ int drive_init(void)
         drive->GCR_write_value = 0x55;
         drive->GCR_track_start_ptr = NULL;
         drive->GCR_current_track_size = 0;
+        drive->GCR_track_cache_num = 0;
         drive->attach_clk = (CLOCK)0;
         drive->detach_clk = (CLOCK)0;
         drive->attach_detach_clk = (CLOCK)0;
@@ -544,10 +545,81 @@ void drive_reset(void)
     }
 }
 
+/*-------------------------------------------------------------------------- */
+
+/* Tracks of D64/D71/X64 images are converted to GCR only when the head gets
+   there.  The most recently used ones are kept around, older ones are
+   dropped again unless they were written to.  */
+
+static int drive_gcr_lazy_image(drive_t *dptr)
+{
+    if (dptr->image == NULL || dptr->GCR_image_loaded == 0) {
+        return 0;
+    }
+    switch (dptr->image->type) {
+        case DISK_IMAGE_TYPE_D64:
+        case DISK_IMAGE_TYPE_D67:
+        case DISK_IMAGE_TYPE_D71:
+        case DISK_IMAGE_TYPE_X64:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int drive_gcr_track_cache_remove(drive_t *dptr, int half_track)
+{
+    unsigned int i;
+
+    for (i = 0; i < dptr->GCR_track_cache_num; i++) {
+        if (dptr->GCR_track_cache[i] == half_track) {
+            dptr->GCR_track_cache_num--;
+            memmove(&dptr->GCR_track_cache[i], &dptr->GCR_track_cache[i + 1],
+                    (dptr->GCR_track_cache_num - i) * sizeof(dptr->GCR_track_cache[0]));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void drive_gcr_track_cache_use(drive_t *dptr, int half_track)
+{
+    disk_track_t *raw = &dptr->gcr->tracks[half_track];
+    int old;
+
+    if (raw->data == NULL) {
+        if (raw->size == 0
+            || disk_image_read_half_track(dptr->image, (unsigned int)half_track + 2, raw) < 0) {
+            return;
+        }
+    } else if (!drive_gcr_track_cache_remove(dptr, half_track)) {
+        /* written to or restored from a snapshot, keep it */
+        return;
+    }
+
+    if (dptr->GCR_track_cache_num == DRIVE_GCR_TRACK_CACHE_SIZE) {
+        old = dptr->GCR_track_cache[--dptr->GCR_track_cache_num];
+        /* keep the size, the track gets converted again when needed */
+        lib_free(dptr->gcr->tracks[old].data);
+        dptr->gcr->tracks[old].data = NULL;
+    }
+    memmove(&dptr->GCR_track_cache[1], &dptr->GCR_track_cache[0],
+            dptr->GCR_track_cache_num * sizeof(dptr->GCR_track_cache[0]));
+    dptr->GCR_track_cache[0] = half_track;
+    dptr->GCR_track_cache_num++;
+}
+
 /* Move the head to half track `num'.  */
 void drive_set_half_track(int num, int side, drive_t *dptr)
 {
     int tmp;
+    int lazy = drive_gcr_lazy_image(dptr);
+
+    /* A modified track that was not written back yet (the 1571 switches
+       sides without doing so) must never be dropped.  */
+    if (lazy && dptr->GCR_dirty_track) {
+        drive_gcr_track_cache_remove(dptr, dptr->current_half_track - 2 + (int)(dptr->side * 70));
+    }
     if ((dptr->type == DRIVE_TYPE_1540
          || dptr->type == DRIVE_TYPE_1541
          || dptr->type == DRIVE_TYPE_1541II
@@ -575,6 +647,10 @@ void drive_set_half_track(int num, int side, drive_t *dptr)
     /* FIXME: why would the offset be different for D71 and G71? */
     tmp = (dptr->image && dptr->image->type == DISK_IMAGE_TYPE_G71) ? DRIVE_HALFTRACKS_1571 : 70;
 
+    if (lazy) {
+        drive_gcr_track_cache_use(dptr, dptr->current_half_track - 2 + (dptr->side * tmp));
+    }
+
     dptr->GCR_track_start_ptr = dptr->gcr->tracks[dptr->current_half_track - 2 + (dptr->side * tmp)].data;
 
     if (dptr->GCR_current_track_size != 0) {
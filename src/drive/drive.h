@@ -141,6 +141,9 @@
 
 #define DRIVE_PC_NUM 4
 
+/* Number of tracks of sector based images kept converted to GCR.  */
+#define DRIVE_GCR_TRACK_CACHE_SIZE 16
+
 /* ------------------------------------------------------------------------- */
 
 typedef struct drive_type_info_s {
@@ -212,6 +215,11 @@ typedef struct drive_s {
     /* Offset of the R/W head on the current track (bytes).  */
     unsigned int GCR_head_offset;
 
+    /* Tracks of sector based images converted to GCR that can be dropped
+       again, most recently used first.  */
+    int GCR_track_cache[DRIVE_GCR_TRACK_CACHE_SIZE];
+    unsigned int GCR_track_cache_num;
+
     /* Are we in read or write mode?  */
     int read_write_mode;
 
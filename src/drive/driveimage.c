@@ -166,6 +166,7 @@ int drive_image_attach(disk_image_t *image, unsigned int unit)
     drive->image->gcr = drive->gcr;
     drive->image->p64 = (void*)drive->p64;
 
+    drive->GCR_track_cache_num = 0;
     if (disk_image_read_image(drive->image) < 0) {
         drive->image = NULL;
         return -1;
@@ -225,9 +226,10 @@ int drive_image_detach(disk_image_t *image, unsigned int unit)
         if (drive->gcr->tracks[i].data) {
             lib_free(drive->gcr->tracks[i].data);
             drive->gcr->tracks[i].data = NULL;
-            drive->gcr->tracks[i].size = 0;
         }
+        drive->gcr->tracks[i].size = 0;
     }
+    drive->GCR_track_cache_num = 0;
     drive->detach_clk = drive_clk[dnr];
     drive->GCR_image_loaded = 0;
     drive->P64_image_loaded = 0;
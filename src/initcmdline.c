@@ -162,6 +162,14 @@ static int cmdline_console(const char *param, void *extra_param)
     video_disabled_mode = 1;
     return 0;
 }
+
+static int cmdline_headless(const char *param, void *extra_param)
+{
+    console_mode = 1;
+    video_disabled_mode = 1;
+    headless_mode = 1;
+    return 0;
+}
 #endif
 
 
@@ -240,6 +248,11 @@ static const cmdline_option_t common_cmdline_options[] = {
       USE_PARAM_STRING, USE_DESCRIPTION_ID,
       IDCLS_UNUSED, IDCLS_CONSOLE_MODE,
       NULL, NULL },
+    { "-headless", CALL_FUNCTION, 0,
+      cmdline_headless, NULL, NULL, NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, N_("Headless batch mode (no UI, no video, no sound device, warp)") },
     { "-core", SET_RESOURCE, 0,
       NULL, NULL, "DoCoreDump", (resource_value_t)1,
       USE_PARAM_STRING, USE_DESCRIPTION_ID,
@@ -57,6 +57,7 @@
 #include "network.h"
 #include "printer.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "sound.h"
@@ -91,6 +92,8 @@ static int machine_init_was_called = 0;
 static int mem_initialized = 0;
 static int ignore_jam = 0;
 static int jam_action = MACHINE_JAM_ACTION_DIALOG;
+
+int maincpu_idle_skip = 0;
 int machine_keymap_index;
 static char *ExitScreenshotName = NULL;
 static char *ExitScreenshotName1 = NULL;
@@ -111,6 +114,11 @@ unsigned int machine_jam(const char *format, ...)
 
     log_message(LOG_DEFAULT, "*** %s", str);
 
+    if (headless_mode && jam_action == MACHINE_JAM_ACTION_DIALOG) {
+        /* nobody is there to answer the dialog */
+        exit(MACHINE_EXIT_JAM);
+    }
+
     if (jam_action == MACHINE_JAM_ACTION_DIALOG) {
         if (monitor_is_remote()) {
             ret = monitor_network_ui_jam_dialog(str);
@@ -216,6 +224,14 @@ void machine_maincpu_init(void)
     maincpu_monitor_interface = lib_calloc(1, sizeof(monitor_interface_t));
 }
 
+/* -limitcycles is handled by an alarm rather than by a check after every
+   instruction in the CPU loop.  */
+static void machine_clk_limit_alarm_handler(CLOCK offset, void *data)
+{
+    log_error(LOG_DEFAULT, "cycle limit reached.");
+    exit(MACHINE_EXIT_CYCLE_LIMIT);
+}
+
 void machine_early_init(void)
 {
     maincpu_alarm_context = alarm_context_new("MainCPU");
@@ -231,6 +247,14 @@ int machine_init(void)
 {
     machine_init_was_called = 1;
 
+    if (maincpu_clk_limit) {
+        alarm_t *alarm;
+
+        alarm = alarm_new(maincpu_alarm_context, "CycleLimit",
+                          machine_clk_limit_alarm_handler, NULL);
+        alarm_set(alarm, maincpu_clk_limit + 1);
+    }
+
     machine_video_init();
 
     fsdevice_init();
@@ -295,6 +319,8 @@ void machine_shutdown(void)
 
     sound_close();
 
+    rewind_shutdown();
+
     printer_shutdown();
     gfxoutput_shutdown();
 
@@ -395,6 +421,13 @@ static int set_exit_screenshot_name1(const char *val, void *param)
     return 0;
 }
 
+static int set_maincpu_idle_skip(int val, void *param)
+{
+    maincpu_idle_skip = val ? 1 : 0;
+
+    return 0;
+}
+
 static resource_string_t resources_string[] = {
     { "ExitScreenshotName", "", RES_EVENT_NO, NULL,
       &ExitScreenshotName, set_exit_screenshot_name, NULL },
@@ -413,6 +446,28 @@ static const resource_int_t resources_int[] = {
     RESOURCE_INT_LIST_END
 };
 
+static const resource_int_t resources_int_idle_skip[] = {
+    { "MainCPUIdleSkip", 0, RES_EVENT_NO, NULL,
+      &maincpu_idle_skip, set_maincpu_idle_skip, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+/* Idle loop skipping is only built into the plain 6510 core of maincpu.c,
+   see MAINCPU_IDLE_SKIP there.  */
+static int machine_has_idle_skip(void)
+{
+    switch (machine_class) {
+        case VICE_MACHINE_C64:
+        case VICE_MACHINE_PET:
+        case VICE_MACHINE_CBM5x0:
+        case VICE_MACHINE_CBM6x0:
+        case VICE_MACHINE_VSID:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 int machine_common_resources_init(void)
 {
     if (machine_class != VICE_MACHINE_VSID) {
@@ -425,6 +480,11 @@ int machine_common_resources_init(void)
             }
         }
     }
+    if (machine_has_idle_skip()) {
+        if (resources_register_int(resources_int_idle_skip) < 0) {
+            return -1;
+        }
+    }
     return resources_register_int(resources_int);
 }
 
@@ -457,6 +517,20 @@ static const cmdline_option_t cmdline_options[] = {
     CMDLINE_LIST_END
 };
 
+static const cmdline_option_t cmdline_options_idle_skip[] = {
+    { "-idleskip", SET_RESOURCE, 0,
+      NULL, NULL, "MainCPUIdleSkip", (resource_value_t)1,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, N_("Skip ahead over main CPU idle loops") },
+    { "+idleskip", SET_RESOURCE, 0,
+      NULL, NULL, "MainCPUIdleSkip", (resource_value_t)0,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, N_("Execute main CPU idle loops cycle by cycle") },
+    CMDLINE_LIST_END
+};
+
 static const cmdline_option_t cmdline_options_vsid[] = {
     { "-jamaction", SET_RESOURCE, 1, NULL, NULL, "JAMAction", NULL,
       USE_PARAM_ID, USE_DESCRIPTION_ID, IDCLS_P_TYPE, IDCLS_SET_MACHINE_JAM_ACTION,
@@ -466,6 +540,11 @@ static const cmdline_option_t cmdline_options_vsid[] = {
 
 int machine_common_cmdline_options_init(void)
 {
+    if (machine_has_idle_skip()) {
+        if (cmdline_register_options(cmdline_options_idle_skip) < 0) {
+            return -1;
+        }
+    }
     if (machine_class == VICE_MACHINE_C128) {
         return cmdline_register_options(cmdline_options_c128);
     } else if (machine_class == VICE_MACHINE_VSID) {
@@ -74,6 +74,18 @@ const
 #endif
 int console_mode;
 extern int video_disabled_mode;
+extern int headless_mode;
+
+/* Exit codes of a headless (batch) run. A value written to the debug
+   cartridge is passed through as the exit code. Only with -headless, the
+   values of the codes below are reserved and a debug cartridge writing
+   them exits with MACHINE_EXIT_DEBUGCART_FAIL instead. */
+#define MACHINE_EXIT_CYCLE_LIMIT        1               /* -limitcycles reached */
+#define MACHINE_EXIT_JAM                2               /* CPU JAM, -headless only */
+#define MACHINE_EXIT_DEBUGCART_FAIL     255             /* debug cart wrote a reserved value, -headless only */
+
+#define MACHINE_EXIT_DEBUGCART(n) \
+    ((headless_mode && (((n) == MACHINE_EXIT_CYCLE_LIMIT) || ((n) == MACHINE_EXIT_JAM))) ? MACHINE_EXIT_DEBUGCART_FAIL : (n))
 
 #define MACHINE_JAM_ACTION_DIALOG       0
 #define MACHINE_JAM_ACTION_CONTINUE     1
@@ -142,6 +154,13 @@ extern int machine_write_snapshot(const char *name, int save_roms,
 /* Read a snapshot.  */
 extern int machine_read_snapshot(const char *name, int even_mode);
 
+/* Write a snapshot into a memory buffer, which the caller must free with
+   `lib_free()', and read it back.  Returns -1 if the machine does not
+   support memory snapshots.  */
+extern int machine_write_snapshot_mem(uint8_t **data_return, size_t *size_return,
+                                      int save_roms, int save_disks, int event_mode);
+extern int machine_read_snapshot_mem(const uint8_t *data, size_t size, int event_mode);
+
 /* handle pending interrupts - needed by libsid.a.  */
 extern void machine_handle_pending_alarms(int num_write_cycles);
 
@@ -91,6 +91,7 @@ const
 #endif
 int console_mode = 0;
 int video_disabled_mode = 0;
+int headless_mode = 0;
 static int init_done = 0;
 
 
@@ -116,9 +117,11 @@ int main_program(int argc, char **argv)
 
     lib_init_rand();
 
-    /* Check for -config and -console before initializing the user interface.
-       -config  => use specified configuration file
-       -console => no user interface
+    /* Check for -config, -console and -headless before initializing the
+       user interface.
+       -config   => use specified configuration file
+       -console  => no user interface
+       -headless => no user interface, no video, no sound device, no throttling
     */
     DBG(("main:early cmdline(argc:%d)\n", argc));
     for (i = 0; i < argc; i++) {
@@ -126,6 +129,10 @@ int main_program(int argc, char **argv)
         if ((!strcmp(argv[i], "-console")) || (!strcmp(argv[i], "--console"))) {
             console_mode = 1;
             video_disabled_mode = 1;
+        } else if ((!strcmp(argv[i], "-headless")) || (!strcmp(argv[i], "--headless"))) {
+            console_mode = 1;
+            video_disabled_mode = 1;
+            headless_mode = 1;
         } else
 #endif
         if ((!strcmp(argv[i], "-config")) || (!strcmp(argv[i], "--config"))) {
@@ -213,6 +220,13 @@ int main_program(int argc, char **argv)
         return -1;
     }
 
+    if (headless_mode) {
+        /* Batch runs only care about the final machine state: discard the
+           audio through the dummy device and never sleep in vsync.  */
+        resources_set_string("SoundDeviceName", "dummy");
+        resources_set_int("WarpMode", 1);
+    }
+
     program_name = archdep_program_name();
 
     /* VICE boot sequence.  */
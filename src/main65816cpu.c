@@ -341,11 +341,6 @@ void maincpu_mainloop(void)
 #include "65816core.c"
 
         maincpu_int_status->num_dma_per_opcode = 0;
-
-        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
-            log_error(LOG_DEFAULT, "cycle limit reached.");
-            exit(EXIT_FAILURE);
-        }
 #if 0
         if (CLK > 246171754)
             debug.maincpu_traceflg = 1;
@@ -458,6 +458,60 @@ void maincpu_resync_limits(void)
     int bank_start = 0;
     int bank_limit = 0;
 
+/* ------------------------------------------------------------------------- */
+
+/* Idle loop skipping, only for the plain 6510 cores that have no extra
+   per-instruction work.  */
+#if !defined(C64DTV) && !defined(CPU_8502) && !defined(CPU_DELAY_CLK) \
+    && !defined(CPU_REFRESH_CLK) && !defined(CYCLE_EXACT_ALARM) \
+    && !defined(FEATURE_CPUMEMHISTORY)
+#define MAINCPU_IDLE_SKIP
+#endif
+
+#ifdef MAINCPU_IDLE_SKIP
+/* Called after an instruction has been executed.  If it was "JMP *" or a
+   taken branch to itself, the CPU spins without touching anything but the
+   clock until an interrupt comes in.  Interrupts are only ever triggered
+   from alarms, so we can advance the clock to the start of the first
+   iteration at or after the next pending alarm, exactly where the alarm
+   would be dispatched when executing the loop.  */
+inline static void maincpu_skip_idle_loop(void)
+{
+    CLOCK next_alarm_clk;
+    CLOCK loops;
+    uint8_t *p;
+
+    if (last_opcode_addr != reg_pc
+        || maincpu_int_status->global_pending_int != IK_NONE
+        || (int)(reg_pc + 2) >= bank_limit) {
+        return;
+    }
+
+    p = bank_base + reg_pc;
+    if (p[0] == 0x4c) {
+        /* JMP $nnnn: 3 cycles */
+        if ((unsigned int)(p[1] | (p[2] << 8)) != reg_pc) {
+            return;
+        }
+    } else if ((p[0] & 0x1f) == 0x10) {
+        /* Bxx: 3 cycles if taken without crossing a page */
+        if (p[1] != 0xfe || ((reg_pc + 2) & 0xff00) != (reg_pc & 0xff00)) {
+            return;
+        }
+    } else {
+        return;
+    }
+
+    next_alarm_clk = alarm_context_next_pending_clk(maincpu_alarm_context);
+    if (next_alarm_clk == CLOCK_MAX || maincpu_clk >= next_alarm_clk) {
+        return;
+    }
+
+    loops = (next_alarm_clk - maincpu_clk + 2) / 3;
+    maincpu_clk += loops * 3;
+}
+#endif
+
 void maincpu_mainloop(void)
 {
 #ifdef EMSCRIPTEN
@@ -534,10 +588,15 @@ void maincpu_mainloop(void)
 
         maincpu_int_status->num_dma_per_opcode = 0;
 
-        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
-            log_error(LOG_DEFAULT, "cycle limit reached.");
-            exit(EXIT_FAILURE);
+#ifdef MAINCPU_IDLE_SKIP
+        if (maincpu_idle_skip
+#ifdef DEBUG
+            && !TRACEFLG
+#endif
+            ) {
+            maincpu_skip_idle_loop();
         }
+#endif
 #if 0
         if (CLK > 246171754) {
             debug.maincpu_traceflg = 1;
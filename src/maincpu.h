@@ -57,6 +57,9 @@ extern int maincpu_rmw_flag;
 extern CLOCK maincpu_clk;
 extern CLOCK maincpu_clk_limit;
 
+/* if != 0, skip ahead over idle loops (see `MainCPUIdleSkip') */
+extern int maincpu_idle_skip;
+
 /* 8502 cycle stretch indicator */
 extern int maincpu_stretch;
 
@@ -71,6 +71,16 @@ static checkpoint_list_t *breakpoints[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_load[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_store[NUM_MEMSPACES];
 
+/* Bitmaps of the locations covered by each checkpoint list, so that the
+   common "no checkpoint here" case is a single bit test.  Only the low 16
+   bits of the location are used, a set bit just means the list must be
+   searched.  NULL while the list is empty.  */
+#define CHECKPOINT_MAP_SIZE (0x10000 / 8)
+
+static uint8_t *breakpoints_map[NUM_MEMSPACES];
+static uint8_t *watchpoints_load_map[NUM_MEMSPACES];
+static uint8_t *watchpoints_store_map[NUM_MEMSPACES];
+
 
 void mon_breakpoint_init(void)
 {
@@ -140,8 +150,54 @@ static checkpoint_t *find_checkpoint(int brknum)
     return NULL;
 }
 
+static void update_checkpoint_map(checkpoint_list_t *head, uint8_t **map)
+{
+    checkpoint_list_t *ptr;
+    unsigned int start, span, i;
+
+    if (head == NULL) {
+        lib_free(*map);
+        *map = NULL;
+        return;
+    }
+
+    if (*map == NULL) {
+        *map = lib_malloc(CHECKPOINT_MAP_SIZE);
+    }
+    memset(*map, 0, CHECKPOINT_MAP_SIZE);
+
+    for (ptr = head; ptr != NULL; ptr = ptr->next) {
+        start = addr_location(ptr->checkpt->start_addr);
+        if (mon_is_valid_addr(ptr->checkpt->end_addr)) {
+            /* ranges may wrap around the end of the address space */
+            span = addr_mask(addr_location(ptr->checkpt->end_addr) - start);
+        } else {
+            span = 0;
+        }
+
+        if (span >= 0xffff) {
+            memset(*map, 0xff, CHECKPOINT_MAP_SIZE);
+            return;
+        }
+        for (i = 0; i <= span; i++) {
+            unsigned int loc = (start + i) & 0xffff;
+
+            (*map)[loc >> 3] |= (uint8_t)(1 << (loc & 7));
+        }
+    }
+}
+
+static void update_checkpoint_maps(MEMSPACE mem)
+{
+    update_checkpoint_map(breakpoints[mem], &breakpoints_map[mem]);
+    update_checkpoint_map(watchpoints_load[mem], &watchpoints_load_map[mem]);
+    update_checkpoint_map(watchpoints_store[mem], &watchpoints_store_map[mem]);
+}
+
 static void update_checkpoint_state(MEMSPACE mem)
 {
+    update_checkpoint_maps(mem);
+
     if (watchpoints_load[mem] != NULL || watchpoints_store[mem] != NULL) {
         monitor_mask[mem] |= MI_WATCH;
         mon_interfaces[mem]->toggle_watchpoints_func(
@@ -394,6 +450,7 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
     checkpoint_list_t *ptr;
     checkpoint_t *cp;
     checkpoint_list_t *list;
+    uint8_t *map;
     monitor_cpu_type_t *monitor_cpu;
     bool must_stop = FALSE;
     MON_ADDR instpc;
@@ -401,8 +458,25 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
     char is_loadstore = 0;
     const char *op_str;
     const char *action_str;
-    int monbank = mon_interfaces[mem]->current_bank;
+    int monbank;
+
+    switch (op) {
+        case e_load:
+            map = watchpoints_load_map[mem];
+            break;
+        case e_store:
+            map = watchpoints_store_map[mem];
+            break;
+        default: /* e_exec */
+            map = breakpoints_map[mem];
+            break;
+    }
+
+    if (map == NULL || !(map[(addr & 0xffff) >> 3] & (1 << (addr & 7)))) {
+        return FALSE;
+    }
 
+    monbank = mon_interfaces[mem]->current_bank;
     monitor_cpu = monitor_cpu_for_memspace[mem];
     instpc = new_addr(mem, (monitor_cpu->mon_register_get_val)(mem, e_PC));
     loadstorepc = new_addr(mem, lastpc);
@@ -623,6 +697,7 @@ void mon_breakpoint_unset(MON_ADDR address)
     if (ptr) {
         /* there's a breakpoint, so remove it */
         remove_checkpoint_from_list( &breakpoints[mem], ptr->checkpt );
+        update_checkpoint_maps(mem);
     }
 }
 
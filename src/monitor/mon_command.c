@@ -165,6 +165,13 @@ static const mon_cmds_t mon_cmd_array[] = {
       IDGS_MON_RETURN_DESCRIPTION,
       NULL, NULL },
 
+    { "rewind", "",
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      NULL, 0,
+      { IDGS_UNUSED, IDGS_UNUSED, IDGS_UNUSED, IDGS_UNUSED },
+      IDGS_UNUSED,
+      "[<count>|reset]", N_("Without argument, show the number of captured rewind states.\nWith <count>, go back to that state (0 = newest) when leaving the monitor.\n'reset' drops all states.") },
+
     { "screen", "sc",
       USE_PARAM_STRING, USE_DESCRIPTION_ID,
       NULL, 0,
@@ -81,6 +81,7 @@
 #include "monitor_network.h"
 #include "montypes.h"
 #include "resources.h"
+#include "rewind.h"
 #include "screenshot.h"
 #include "sysfile.h"
 #include "translate.h"
@@ -1010,6 +1011,25 @@ void mon_stopwatch_reset(void)
     mon_out("Stopwatch reset to 0.\n");
 }
 
+void mon_rewind(int entry)
+{
+    unsigned int num = rewind_get_num_entries();
+
+    if (entry < 0) {
+        mon_out("%u rewind states captured.\n", num);
+    } else if (rewind_restore((unsigned int)entry) < 0) {
+        mon_out("No rewind state %d, %u captured.\n", entry, num);
+    } else {
+        mon_out("Going back to rewind state %d when leaving the monitor.\n", entry);
+    }
+}
+
+void mon_rewind_clear(void)
+{
+    rewind_clear();
+    mon_out("Rewind states dropped.\n");
+}
+
 /* Local helper functions for building the lists */
 static monitor_cpu_type_t* find_monitor_cpu_type(CPU_TYPE_t cputype)
 {
@@ -2346,6 +2346,9 @@ static unsigned char sstrcmp(unsigned char *line, const char **wordlist, int tok
 const char machine_name[] = "PETCAT";
 int machine_class = VICE_MACHINE_PETCAT;
 
+/* read by the SDL archdep_init(), the tools never run headless */
+int headless_mode = 0;
+
 const char *machine_get_name(void)
 {
     return machine_name;
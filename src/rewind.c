@@ -0,0 +1,504 @@
+/*
+ * rewind.c - Rewind buffer built on in-memory snapshots.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The machine state is captured every `RewindInterval' frames with
+   `machine_write_snapshot_mem()'.  Every REWIND_KEYFRAME_INTERVAL captures a
+   keyframe is stored, the captures in between only store the XOR against
+   that keyframe.  Both are run length encoded:
+
+     <zero run> <literal count> <literal bytes> ...
+
+   with the counts stored as 7 bit varints.  Since most of RAM, the drive
+   RAM and the chip registers do not change from one second to the next,
+   the deltas are mostly long zero runs.
+
+   When the buffer exceeds `RewindBufferSize' megabytes the oldest keyframe
+   is dropped together with all deltas depending on it.
+
+   Disk images are not part of the captured state (save_disks = 0).  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "resources.h"
+#include "rewind.h"
+#include "translate.h"
+#include "types.h"
+
+/* #define DEBUG_REWIND */
+
+#ifdef DEBUG_REWIND
+#define DBG(x)  log_debug x
+#else
+#define DBG(x)
+#endif
+
+/* Number of captures between two keyframes.  */
+#define REWIND_KEYFRAME_INTERVAL    32
+
+/* Zero runs shorter than this are kept inside the literal run.  */
+#define REWIND_MIN_ZERO_RUN         4
+
+typedef struct rewind_entry_s {
+    /* Flag: this is a keyframe, otherwise XOR against the last keyframe.  */
+    int keyframe;
+
+    /* Size of the decoded snapshot.  */
+    size_t size;
+
+    /* Encoded data.  */
+    uint8_t *data;
+    size_t data_size;
+
+    struct rewind_entry_s *prev;
+    struct rewind_entry_s *next;
+} rewind_entry_t;
+
+static log_t rewind_log = LOG_ERR;
+
+/* Oldest and newest entry.  */
+static rewind_entry_t *rewind_head = NULL;
+static rewind_entry_t *rewind_tail = NULL;
+
+static unsigned int rewind_num_entries = 0;
+static size_t rewind_total_size = 0;
+
+/* Raw copy of the newest keyframe, deltas are encoded against it.  */
+static uint8_t *keyframe_raw = NULL;
+static size_t keyframe_size = 0;
+static unsigned int captures_since_keyframe = 0;
+
+static unsigned int frames_since_capture = 0;
+static int capture_pending = 0;
+static int restore_pending = 0;
+
+/* Resources.  */
+static int rewind_buffer_size;  /* MB, 0 = disabled */
+static int rewind_interval;     /* frames */
+
+/* ------------------------------------------------------------------------- */
+
+static uint8_t *put_varint(uint8_t *p, size_t value)
+{
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, size_t *value)
+{
+    size_t v = 0;
+    int shift = 0;
+
+    while (p < end) {
+        v |= (size_t)(*p & 0x7f) << shift;
+        if (!(*p++ & 0x80)) {
+            *value = v;
+            return p;
+        }
+        shift += 7;
+    }
+    return NULL;
+}
+
+/* Encode `data' XOR `base' (`base' may be NULL), returns a lib_malloc'ed
+   buffer.  */
+static uint8_t *rewind_encode(const uint8_t *data, const uint8_t *base, size_t size, size_t *size_return)
+{
+    uint8_t *out, *p;
+    size_t i = 0, zero_start, lit_start, lit_end, j;
+
+    /* each record covers at least one literal byte, so the output can only
+       grow by a few varint bytes in total */
+    out = lib_malloc(size + size / REWIND_MIN_ZERO_RUN + 16);
+    p = out;
+
+    while (i < size) {
+        /* zero run */
+        zero_start = i;
+        while (i < size && (data[i] ^ (base ? base[i] : 0)) == 0) {
+            i++;
+        }
+        p = put_varint(p, i - zero_start);
+
+        /* literal run, ends at the first zero run long enough to pay off */
+        lit_start = i;
+        lit_end = i;
+        while (i < size) {
+            if ((data[i] ^ (base ? base[i] : 0)) != 0) {
+                lit_end = ++i;
+                continue;
+            }
+            for (j = i; j < size && j - i < REWIND_MIN_ZERO_RUN; j++) {
+                if ((data[j] ^ (base ? base[j] : 0)) != 0) {
+                    break;
+                }
+            }
+            if (j - i >= REWIND_MIN_ZERO_RUN || j == size) {
+                break;
+            }
+            i = j;
+        }
+        i = lit_end;
+        p = put_varint(p, lit_end - lit_start);
+        for (j = lit_start; j < lit_end; j++) {
+            *p++ = data[j] ^ (base ? base[j] : 0);
+        }
+    }
+
+    *size_return = (size_t)(p - out);
+    return lib_realloc(out, *size_return);
+}
+
+/* Decode an entry into `out', which holds the base (the keyframe) for
+   deltas.  */
+static int rewind_decode(const rewind_entry_t *e, uint8_t *out)
+{
+    const uint8_t *p = e->data;
+    const uint8_t *end = e->data + e->data_size;
+    size_t pos = 0, zeros, lits, j;
+
+    while (p < end) {
+        p = get_varint(p, end, &zeros);
+        if (p == NULL || pos + zeros > e->size) {
+            return -1;
+        }
+        if (e->keyframe) {
+            memset(out + pos, 0, zeros);
+        }
+        pos += zeros;
+
+        p = get_varint(p, end, &lits);
+        if (p == NULL || pos + lits > e->size || lits > (size_t)(end - p)) {
+            return -1;
+        }
+        if (e->keyframe) {
+            memcpy(out + pos, p, lits);
+        } else {
+            for (j = 0; j < lits; j++) {
+                out[pos + j] ^= p[j];
+            }
+        }
+        pos += lits;
+        p += lits;
+    }
+
+    if (e->keyframe && pos < e->size) {
+        memset(out + pos, 0, e->size - pos);
+    }
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void rewind_entry_free(rewind_entry_t *e)
+{
+    rewind_total_size -= e->data_size + sizeof(rewind_entry_t);
+    rewind_num_entries--;
+    lib_free(e->data);
+    lib_free(e);
+}
+
+static void rewind_drop_keyframe(void)
+{
+    lib_free(keyframe_raw);
+    keyframe_raw = NULL;
+    keyframe_size = 0;
+    captures_since_keyframe = 0;
+}
+
+/* Drop the oldest keyframe and the deltas depending on it.  */
+static void rewind_evict_oldest(void)
+{
+    rewind_entry_t *e;
+
+    do {
+        e = rewind_head;
+        rewind_head = e->next;
+        if (rewind_head) {
+            rewind_head->prev = NULL;
+        } else {
+            rewind_tail = NULL;
+        }
+        rewind_entry_free(e);
+    } while (rewind_head != NULL && !rewind_head->keyframe);
+
+    if (rewind_head == NULL) {
+        rewind_drop_keyframe();
+    }
+}
+
+/* Drop all entries newer than `e'.  */
+static void rewind_truncate_after(rewind_entry_t *e)
+{
+    rewind_entry_t *next;
+
+    while (rewind_tail != e) {
+        next = rewind_tail;
+        rewind_tail = next->prev;
+        rewind_tail->next = NULL;
+        rewind_entry_free(next);
+    }
+}
+
+static void rewind_enforce_budget(void)
+{
+    size_t budget = (size_t)rewind_buffer_size << 20;
+
+    while (rewind_head != NULL && rewind_total_size > budget) {
+        rewind_evict_oldest();
+    }
+}
+
+void rewind_clear(void)
+{
+    while (rewind_head != NULL) {
+        rewind_evict_oldest();
+    }
+    rewind_drop_keyframe();
+    frames_since_capture = 0;
+}
+
+unsigned int rewind_get_num_entries(void)
+{
+    return rewind_num_entries;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void rewind_capture_trap(uint16_t addr, void *data)
+{
+    rewind_entry_t *e;
+    uint8_t *snap;
+    size_t size;
+
+    capture_pending = 0;
+
+    if (rewind_buffer_size == 0) {
+        return;
+    }
+
+    if (machine_write_snapshot_mem(&snap, &size, 0, 0, 0) < 0) {
+        log_error(rewind_log, "Cannot capture machine state, rewind disabled.");
+        resources_set_int("RewindBufferSize", 0);
+        return;
+    }
+
+    e = lib_calloc(1, sizeof(rewind_entry_t));
+    e->size = size;
+
+    if (keyframe_raw == NULL || size != keyframe_size
+        || captures_since_keyframe >= REWIND_KEYFRAME_INTERVAL) {
+        e->keyframe = 1;
+        e->data = rewind_encode(snap, NULL, size, &e->data_size);
+        lib_free(keyframe_raw);
+        keyframe_raw = snap;
+        keyframe_size = size;
+        captures_since_keyframe = 0;
+    } else {
+        e->data = rewind_encode(snap, keyframe_raw, size, &e->data_size);
+        lib_free(snap);
+        captures_since_keyframe++;
+    }
+
+    DBG(("rewind: %s %u -> %u bytes", e->keyframe ? "key" : "delta",
+         (unsigned int)size, (unsigned int)e->data_size));
+
+    e->prev = rewind_tail;
+    if (rewind_tail) {
+        rewind_tail->next = e;
+    } else {
+        rewind_head = e;
+    }
+    rewind_tail = e;
+    rewind_num_entries++;
+    rewind_total_size += e->data_size + sizeof(rewind_entry_t);
+
+    rewind_enforce_budget();
+}
+
+static void rewind_restore_trap(uint16_t addr, void *data)
+{
+    unsigned int n = vice_ptr_to_uint(data);
+    rewind_entry_t *e, *key;
+    uint8_t *kbuf, *sbuf;
+    unsigned int deltas = 0;
+
+    restore_pending = 0;
+
+    for (e = rewind_tail; e != NULL && n > 0; e = e->prev) {
+        n--;
+    }
+    if (e == NULL) {
+        return;
+    }
+
+    for (key = e; !key->keyframe; key = key->prev) {
+        deltas++;
+    }
+
+    kbuf = lib_malloc(key->size);
+    if (rewind_decode(key, kbuf) < 0) {
+        log_error(rewind_log, "Corrupt keyframe, rewind buffer cleared.");
+        lib_free(kbuf);
+        rewind_clear();
+        return;
+    }
+
+    if (e == key) {
+        sbuf = kbuf;
+    } else {
+        sbuf = lib_malloc(e->size);
+        memcpy(sbuf, kbuf, e->size);
+        if (rewind_decode(e, sbuf) < 0) {
+            log_error(rewind_log, "Corrupt delta, rewind buffer cleared.");
+            lib_free(sbuf);
+            lib_free(kbuf);
+            rewind_clear();
+            return;
+        }
+    }
+
+    if (machine_read_snapshot_mem(sbuf, e->size, 0) < 0) {
+        log_error(rewind_log, "Cannot restore machine state.");
+    }
+
+    if (sbuf != kbuf) {
+        lib_free(sbuf);
+    }
+
+    /* continue recording from the restored state, new deltas go against
+       the keyframe of the restored entry */
+    rewind_truncate_after(e);
+    lib_free(keyframe_raw);
+    keyframe_raw = kbuf;
+    keyframe_size = key->size;
+    captures_since_keyframe = deltas;
+    frames_since_capture = 0;
+}
+
+int rewind_restore(unsigned int entry)
+{
+    if (entry >= rewind_num_entries || restore_pending) {
+        return -1;
+    }
+
+    restore_pending = 1;
+    interrupt_maincpu_trigger_trap(rewind_restore_trap, uint_to_void_ptr(entry));
+    return 0;
+}
+
+void rewind_vsync(void)
+{
+    if (rewind_buffer_size == 0 || restore_pending) {
+        return;
+    }
+
+    if (++frames_since_capture < (unsigned int)rewind_interval) {
+        return;
+    }
+    frames_since_capture = 0;
+
+    if (!capture_pending) {
+        capture_pending = 1;
+        interrupt_maincpu_trigger_trap(rewind_capture_trap, NULL);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int set_rewind_buffer_size(int val, void *param)
+{
+    if (val < 0) {
+        return -1;
+    }
+
+    rewind_buffer_size = val;
+
+    if (rewind_buffer_size == 0) {
+        rewind_clear();
+    } else {
+        rewind_enforce_budget();
+    }
+    return 0;
+}
+
+static int set_rewind_interval(int val, void *param)
+{
+    if (val < 1) {
+        return -1;
+    }
+
+    rewind_interval = val;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "RewindBufferSize", 0, RES_EVENT_NO, NULL,
+      &rewind_buffer_size, set_rewind_buffer_size, NULL },
+    { "RewindInterval", 50, RES_EVENT_NO, NULL,
+      &rewind_interval, set_rewind_interval, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int rewind_resources_init(void)
+{
+    rewind_log = log_open("Rewind");
+
+    return resources_register_int(resources_int);
+}
+
+static const cmdline_option_t cmdline_options[] = {
+    { "-rewindsize", SET_RESOURCE, 1,
+      NULL, NULL, "RewindBufferSize", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      N_("<MB>"), N_("Size of the rewind buffer in MB (0: disabled)") },
+    { "-rewindinterval", SET_RESOURCE, 1,
+      NULL, NULL, "RewindInterval", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      N_("<frames>"), N_("Capture the machine state for rewind every <frames> frames") },
+    CMDLINE_LIST_END
+};
+
+int rewind_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+void rewind_shutdown(void)
+{
+    rewind_clear();
+}
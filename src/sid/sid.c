@@ -511,7 +511,7 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         }
     }
     if (soc == 2 && scc == 4) {
-        tmp_buf1 = getbuf1(2 * nr);
+        tmp_buf1 = getbuf1(2 * nr * (int)sizeof(int16_t));
         tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
         tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, 2, &tmp_delta_t);
@@ -51,6 +51,7 @@ static char *current_module = NULL;
 static char read_name[SNAPSHOT_MACHINE_NAME_LEN];
 static char *current_machine_name = NULL;
 static char *current_filename = NULL;
+static char snapshot_mem_name[] = "<memory>";
 
 char snapshot_magic_string[] = "VICE Snapshot File\032";
 char snapshot_version_magic_string[] = "VICE Version\032";
@@ -58,10 +59,29 @@ char snapshot_version_magic_string[] = "VICE Version\032";
 #define SNAPSHOT_MAGIC_LEN              19
 #define SNAPSHOT_VERSION_MAGIC_LEN      13
 
-struct snapshot_module_s {
-    /* File descriptor.  */
+/* Snapshots live either in a stdio file or in a growable memory buffer.
+   All reads and writes go through the snapshot_stream_* helpers below, so
+   the module code does not need to know which backend is in use.  */
+typedef struct snapshot_stream_s {
+    /* File descriptor, NULL for memory snapshots.  */
     FILE *file;
 
+    /* Memory buffer, its used size and allocated size.  */
+    uint8_t *buffer;
+    size_t size;
+    size_t alloc;
+
+    /* Current position in the memory buffer.  */
+    size_t pos;
+
+    /* Flag: the buffer belongs to the caller (snapshot_open_mem).  */
+    int foreign_buffer;
+} snapshot_stream_t;
+
+struct snapshot_module_s {
+    /* Stream of the snapshot this module belongs to.  */
+    snapshot_stream_t *stream;
+
     /* Flag: are we writing it?  */
     int write_mode;
 
@@ -76,8 +96,8 @@ struct snapshot_module_s {
 };
 
 struct snapshot_s {
-    /* File descriptor.  */
-    FILE *file;
+    /* File or memory buffer.  */
+    snapshot_stream_t stream;
 
     /* Offset of the first module.  */
     long first_module_offset;
@@ -86,63 +106,157 @@ struct snapshot_s {
     int write_mode;
 };
 
+/* Initial size of the buffer of a memory snapshot, doubled when needed.  */
+#define SNAPSHOT_MEM_INITIAL_SIZE   0x10000
+
+/* Word and dword arrays are converted to little endian in chunks of this
+   size before they are handed to the stream.  */
+#define SNAPSHOT_CHUNK_SIZE         256
+
 /* ------------------------------------------------------------------------- */
 
-static int snapshot_write_byte(FILE *f, uint8_t data)
+static int snapshot_stream_write(snapshot_stream_t *f, const void *data, size_t len)
 {
-    if (fputc(data, f) == EOF) {
-        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+    size_t new_alloc;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    if (f->file != NULL) {
+        return (fwrite(data, len, 1, f->file) < 1) ? -1 : 0;
+    }
+
+    if (f->pos + len > f->alloc) {
+        new_alloc = f->alloc ? f->alloc : SNAPSHOT_MEM_INITIAL_SIZE;
+        while (f->pos + len > new_alloc) {
+            new_alloc *= 2;
+        }
+        f->buffer = lib_realloc(f->buffer, new_alloc);
+        f->alloc = new_alloc;
+    }
+
+    memcpy(f->buffer + f->pos, data, len);
+    f->pos += len;
+    if (f->pos > f->size) {
+        f->size = f->pos;
+    }
+
+    return 0;
+}
+
+static int snapshot_stream_read(snapshot_stream_t *f, void *data, size_t len)
+{
+    if (len == 0) {
+        return 0;
+    }
+
+    if (f->file != NULL) {
+        return (fread(data, len, 1, f->file) < 1) ? -1 : 0;
+    }
+
+    if (f->pos + len > f->size) {
         return -1;
     }
 
+    memcpy(data, f->buffer + f->pos, len);
+    f->pos += len;
+
     return 0;
 }
 
-static int snapshot_write_word(FILE *f, uint16_t data)
+static long snapshot_stream_tell(snapshot_stream_t *f)
 {
-    if (snapshot_write_byte(f, (uint8_t)(data & 0xff)) < 0
-        || snapshot_write_byte(f, (uint8_t)(data >> 8)) < 0) {
+    if (f->file != NULL) {
+        return ftell(f->file);
+    }
+
+    return (long)f->pos;
+}
+
+static int snapshot_stream_seek(snapshot_stream_t *f, long offset)
+{
+    if (f->file != NULL) {
+        return fseek(f->file, offset, SEEK_SET);
+    }
+
+    if (offset < 0 || (size_t)offset > f->size) {
         return -1;
     }
 
+    f->pos = (size_t)offset;
     return 0;
 }
 
-static int snapshot_write_dword(FILE *f, uint32_t data)
+/* ------------------------------------------------------------------------- */
+
+static int snapshot_write_byte(snapshot_stream_t *f, uint8_t data)
 {
-    if (snapshot_write_word(f, (uint16_t)(data & 0xffff)) < 0
-        || snapshot_write_word(f, (uint16_t)(data >> 16)) < 0) {
+    if (snapshot_stream_write(f, &data, 1) < 0) {
+        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
         return -1;
     }
 
     return 0;
 }
 
-static int snapshot_write_double(FILE *f, double data)
+static int snapshot_write_word(snapshot_stream_t *f, uint16_t data)
 {
-    uint8_t *byte_data = (uint8_t *)&data;
-    int i;
+    uint8_t buf[2];
 
-    for (i = 0; i < sizeof(double); i++) {
-        if (snapshot_write_byte(f, byte_data[i]) < 0) {
-            return -1;
-        }
+    buf[0] = (uint8_t)(data & 0xff);
+    buf[1] = (uint8_t)(data >> 8);
+
+    if (snapshot_stream_write(f, buf, sizeof(buf)) < 0) {
+        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+        return -1;
     }
+
     return 0;
 }
 
-static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char,
+static int snapshot_write_dword(snapshot_stream_t *f, uint32_t data)
+{
+    uint8_t buf[4];
+
+    buf[0] = (uint8_t)(data & 0xff);
+    buf[1] = (uint8_t)((data >> 8) & 0xff);
+    buf[2] = (uint8_t)((data >> 16) & 0xff);
+    buf[3] = (uint8_t)(data >> 24);
+
+    if (snapshot_stream_write(f, buf, sizeof(buf)) < 0) {
+        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int snapshot_write_double(snapshot_stream_t *f, double data)
+{
+    if (snapshot_stream_write(f, &data, sizeof(double)) < 0) {
+        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int snapshot_write_padded_string(snapshot_stream_t *f, const char *s, uint8_t pad_char,
                                         int len)
 {
-    int i, found_zero;
-    uint8_t c;
+    uint8_t buf[SNAPSHOT_CHUNK_SIZE];
+    int i, n, found_zero;
 
-    for (i = found_zero = 0; i < len; i++) {
-        if (!found_zero && s[i] == 0) {
-            found_zero = 1;
+    for (i = found_zero = 0; i < len; i += n) {
+        for (n = 0; n < SNAPSHOT_CHUNK_SIZE && i + n < len; n++) {
+            if (!found_zero && s[i + n] == 0) {
+                found_zero = 1;
+            }
+            buf[n] = found_zero ? (uint8_t)pad_char : (uint8_t)s[i + n];
         }
-        c = found_zero ? (uint8_t)pad_char : (uint8_t) s[i];
-        if (snapshot_write_byte(f, c) < 0) {
+        if (snapshot_stream_write(f, buf, (size_t)n) < 0) {
+            snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
             return -1;
         }
     }
@@ -150,9 +264,9 @@ static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char
     return 0;
 }
 
-static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int num)
+static int snapshot_write_byte_array(snapshot_stream_t *f, const uint8_t *data, unsigned int num)
 {
-    if (num > 0 && fwrite(data, (size_t)num, 1, f) < 1) {
+    if (snapshot_stream_write(f, data, (size_t)num) < 0) {
         snapshot_error = SNAPSHOT_WRITE_BYTE_ARRAY_ERROR;
         return -1;
     }
@@ -160,36 +274,56 @@ static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int
     return 0;
 }
 
-static int snapshot_write_word_array(FILE *f, const uint16_t *data, unsigned int num)
+static int snapshot_write_word_array(snapshot_stream_t *f, const uint16_t *data, unsigned int num)
 {
-    unsigned int i;
-
-    for (i = 0; i < num; i++) {
-        if (snapshot_write_word(f, data[i]) < 0) {
+    uint8_t buf[SNAPSHOT_CHUNK_SIZE];
+    unsigned int i, n;
+
+    while (num > 0) {
+        n = (num > SNAPSHOT_CHUNK_SIZE / 2) ? SNAPSHOT_CHUNK_SIZE / 2 : num;
+        for (i = 0; i < n; i++) {
+            buf[i * 2] = (uint8_t)(data[i] & 0xff);
+            buf[i * 2 + 1] = (uint8_t)(data[i] >> 8);
+        }
+        if (snapshot_stream_write(f, buf, n * 2) < 0) {
+            snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
             return -1;
         }
+        data += n;
+        num -= n;
     }
 
     return 0;
 }
 
-static int snapshot_write_dword_array(FILE *f, const uint32_t *data, unsigned int num)
+static int snapshot_write_dword_array(snapshot_stream_t *f, const uint32_t *data, unsigned int num)
 {
-    unsigned int i;
-
-    for (i = 0; i < num; i++) {
-        if (snapshot_write_dword(f, data[i]) < 0) {
+    uint8_t buf[SNAPSHOT_CHUNK_SIZE];
+    unsigned int i, n;
+
+    while (num > 0) {
+        n = (num > SNAPSHOT_CHUNK_SIZE / 4) ? SNAPSHOT_CHUNK_SIZE / 4 : num;
+        for (i = 0; i < n; i++) {
+            buf[i * 4] = (uint8_t)(data[i] & 0xff);
+            buf[i * 4 + 1] = (uint8_t)((data[i] >> 8) & 0xff);
+            buf[i * 4 + 2] = (uint8_t)((data[i] >> 16) & 0xff);
+            buf[i * 4 + 3] = (uint8_t)(data[i] >> 24);
+        }
+        if (snapshot_stream_write(f, buf, n * 4) < 0) {
+            snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
             return -1;
         }
+        data += n;
+        num -= n;
     }
 
     return 0;
 }
 
 
-static int snapshot_write_string(FILE *f, const char *s)
+static int snapshot_write_string(snapshot_stream_t *f, const char *s)
 {
-    size_t len, i;
+    size_t len;
 
     len = s ? (strlen(s) + 1) : 0;      /* length includes nullbyte */
 
@@ -197,74 +331,65 @@ static int snapshot_write_string(FILE *f, const char *s)
         return -1;
     }
 
-    for (i = 0; i < len; i++) {
-        if (snapshot_write_byte(f, s[i]) < 0) {
-            return -1;
-        }
+    if (snapshot_stream_write(f, s, len) < 0) {
+        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+        return -1;
     }
 
     return (int)(len + sizeof(uint16_t));
 }
 
-static int snapshot_read_byte(FILE *f, uint8_t *b_return)
+static int snapshot_read_byte(snapshot_stream_t *f, uint8_t *b_return)
 {
-    int c;
-
-    c = fgetc(f);
-    if (c == EOF) {
+    if (snapshot_stream_read(f, b_return, 1) < 0) {
         snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
     }
-    *b_return = (uint8_t)c;
+
     return 0;
 }
 
-static int snapshot_read_word(FILE *f, uint16_t *w_return)
+static int snapshot_read_word(snapshot_stream_t *f, uint16_t *w_return)
 {
-    uint8_t lo, hi;
+    uint8_t buf[2];
 
-    if (snapshot_read_byte(f, &lo) < 0 || snapshot_read_byte(f, &hi) < 0) {
+    if (snapshot_stream_read(f, buf, sizeof(buf)) < 0) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
     }
 
-    *w_return = lo | (hi << 8);
+    *w_return = buf[0] | (buf[1] << 8);
     return 0;
 }
 
-static int snapshot_read_dword(FILE *f, uint32_t *dw_return)
+static int snapshot_read_dword(snapshot_stream_t *f, uint32_t *dw_return)
 {
-    uint16_t lo, hi;
+    uint8_t buf[4];
 
-    if (snapshot_read_word(f, &lo) < 0 || snapshot_read_word(f, &hi) < 0) {
+    if (snapshot_stream_read(f, buf, sizeof(buf)) < 0) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
     }
 
-    *dw_return = lo | (hi << 16);
+    *dw_return = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
     return 0;
 }
 
-static int snapshot_read_double(FILE *f, double *d_return)
+static int snapshot_read_double(snapshot_stream_t *f, double *d_return)
 {
-    int i;
-    int c;
     double val;
-    uint8_t *byte_val = (uint8_t *)&val;
 
-    for (i = 0; i < sizeof(double); i++) {
-        c = fgetc(f);
-        if (c == EOF) {
-            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
-            return -1;
-        }
-        byte_val[i] = (uint8_t)c;
+    if (snapshot_stream_read(f, &val, sizeof(double)) < 0) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+        return -1;
     }
     *d_return = val;
     return 0;
 }
 
-static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num)
+static int snapshot_read_byte_array(snapshot_stream_t *f, uint8_t *b_return, unsigned int num)
 {
-    if (num > 0 && fread(b_return, (size_t)num, 1, f) < 1) {
+    if (snapshot_stream_read(f, b_return, (size_t)num) < 0) {
         snapshot_error = SNAPSHOT_READ_BYTE_ARRAY_ERROR;
         return -1;
     }
@@ -272,35 +397,52 @@ static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num
     return 0;
 }
 
-static int snapshot_read_word_array(FILE *f, uint16_t *w_return, unsigned int num)
+static int snapshot_read_word_array(snapshot_stream_t *f, uint16_t *w_return, unsigned int num)
 {
-    unsigned int i;
+    uint8_t buf[SNAPSHOT_CHUNK_SIZE];
+    unsigned int i, n;
 
-    for (i = 0; i < num; i++) {
-        if (snapshot_read_word(f, w_return + i) < 0) {
+    while (num > 0) {
+        n = (num > SNAPSHOT_CHUNK_SIZE / 2) ? SNAPSHOT_CHUNK_SIZE / 2 : num;
+        if (snapshot_stream_read(f, buf, n * 2) < 0) {
+            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
             return -1;
         }
+        for (i = 0; i < n; i++) {
+            w_return[i] = buf[i * 2] | (buf[i * 2 + 1] << 8);
+        }
+        w_return += n;
+        num -= n;
     }
 
     return 0;
 }
 
-static int snapshot_read_dword_array(FILE *f, uint32_t *dw_return, unsigned int num)
+static int snapshot_read_dword_array(snapshot_stream_t *f, uint32_t *dw_return, unsigned int num)
 {
-    unsigned int i;
+    uint8_t buf[SNAPSHOT_CHUNK_SIZE];
+    unsigned int i, n;
 
-    for (i = 0; i < num; i++) {
-        if (snapshot_read_dword(f, dw_return + i) < 0) {
+    while (num > 0) {
+        n = (num > SNAPSHOT_CHUNK_SIZE / 4) ? SNAPSHOT_CHUNK_SIZE / 4 : num;
+        if (snapshot_stream_read(f, buf, n * 4) < 0) {
+            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
             return -1;
         }
+        for (i = 0; i < n; i++) {
+            dw_return[i] = buf[i * 4] | (buf[i * 4 + 1] << 8)
+                           | (buf[i * 4 + 2] << 16) | ((uint32_t)buf[i * 4 + 3] << 24);
+        }
+        dw_return += n;
+        num -= n;
     }
 
     return 0;
 }
 
-static int snapshot_read_string(FILE *f, char **s)
+static int snapshot_read_string(snapshot_stream_t *f, char **s)
 {
-    int i, len;
+    int len;
     uint16_t w;
     char *p = NULL;
 
@@ -318,11 +460,10 @@ static int snapshot_read_string(FILE *f, char **s)
         p = lib_malloc(len);
         *s = p;
 
-        for (i = 0; i < len; i++) {
-            if (snapshot_read_byte(f, (uint8_t *)(p + i)) < 0) {
-                p[0] = 0;
-                return -1;
-            }
+        if (snapshot_stream_read(f, p, (size_t)len) < 0) {
+            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+            p[0] = 0;
+            return -1;
         }
         p[len - 1] = 0;   /* just to be save */
     }
@@ -333,7 +474,7 @@ static int snapshot_read_string(FILE *f, char **s)
 
 int snapshot_module_write_byte(snapshot_module_t *m, uint8_t b)
 {
-    if (snapshot_write_byte(m->file, b) < 0) {
+    if (snapshot_write_byte(m->stream, b) < 0) {
         return -1;
     }
 
@@ -343,7 +484,7 @@ int snapshot_module_write_byte(snapshot_module_t *m, uint8_t b)
 
 int snapshot_module_write_word(snapshot_module_t *m, uint16_t w)
 {
-    if (snapshot_write_word(m->file, w) < 0) {
+    if (snapshot_write_word(m->stream, w) < 0) {
         return -1;
     }
 
@@ -353,7 +494,7 @@ int snapshot_module_write_word(snapshot_module_t *m, uint16_t w)
 
 int snapshot_module_write_dword(snapshot_module_t *m, uint32_t dw)
 {
-    if (snapshot_write_dword(m->file, dw) < 0) {
+    if (snapshot_write_dword(m->stream, dw) < 0) {
         return -1;
     }
 
@@ -363,7 +504,7 @@ int snapshot_module_write_dword(snapshot_module_t *m, uint32_t dw)
 
 int snapshot_module_write_double(snapshot_module_t *m, double db)
 {
-    if (snapshot_write_double(m->file, db) < 0) {
+    if (snapshot_write_double(m->stream, db) < 0) {
         return -1;
     }
 
@@ -373,7 +514,7 @@ int snapshot_module_write_double(snapshot_module_t *m, double db)
 
 int snapshot_module_write_padded_string(snapshot_module_t *m, const char *s, uint8_t pad_char, int len)
 {
-    if (snapshot_write_padded_string(m->file, s, (uint8_t)pad_char, len) < 0) {
+    if (snapshot_write_padded_string(m->stream, s, (uint8_t)pad_char, len) < 0) {
         return -1;
     }
 
@@ -383,7 +524,7 @@ int snapshot_module_write_padded_string(snapshot_module_t *m, const char *s, uin
 
 int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *b, unsigned int num)
 {
-    if (snapshot_write_byte_array(m->file, b, num) < 0) {
+    if (snapshot_write_byte_array(m->stream, b, num) < 0) {
         return -1;
     }
 
@@ -393,7 +534,7 @@ int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *b, uns
 
 int snapshot_module_write_word_array(snapshot_module_t *m, const uint16_t *w, unsigned int num)
 {
-    if (snapshot_write_word_array(m->file, w, num) < 0) {
+    if (snapshot_write_word_array(m->stream, w, num) < 0) {
         return -1;
     }
 
@@ -403,7 +544,7 @@ int snapshot_module_write_word_array(snapshot_module_t *m, const uint16_t *w, un
 
 int snapshot_module_write_dword_array(snapshot_module_t *m, const uint32_t *dw, unsigned int num)
 {
-    if (snapshot_write_dword_array(m->file, dw, num) < 0) {
+    if (snapshot_write_dword_array(m->stream, dw, num) < 0) {
         return -1;
     }
 
@@ -414,7 +555,7 @@ int snapshot_module_write_dword_array(snapshot_module_t *m, const uint32_t *dw,
 int snapshot_module_write_string(snapshot_module_t *m, const char *s)
 {
     int len;
-    len = snapshot_write_string(m->file, s);
+    len = snapshot_write_string(m->stream, s);
     if (len < 0) {
         snapshot_error = SNAPSHOT_ILLEGAL_STRING_LENGTH_ERROR;
         return -1;
@@ -428,82 +569,82 @@ int snapshot_module_write_string(snapshot_module_t *m, const char *s)
 
 int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
 {
-    if (ftell(m->file) + sizeof(uint8_t) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->stream) + sizeof(uint8_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_byte(m->file, b_return);
+    return snapshot_read_byte(m->stream, b_return);
 }
 
 int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
 {
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->stream) + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_word(m->file, w_return);
+    return snapshot_read_word(m->stream, w_return);
 }
 
 int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
 {
-    if (ftell(m->file) + sizeof(uint32_t) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->stream) + sizeof(uint32_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_dword(m->file, dw_return);
+    return snapshot_read_dword(m->stream, dw_return);
 }
 
 int snapshot_module_read_double(snapshot_module_t *m, double *db_return)
 {
-    if (ftell(m->file) + sizeof(double) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->stream) + sizeof(double) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_double(m->file, db_return);
+    return snapshot_read_double(m->stream, db_return);
 }
 
 int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num) > (long)(m->offset + m->size)) {
+    if ((long)(snapshot_stream_tell(m->stream) + num) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_byte_array(m->file, b_return, num);
+    return snapshot_read_byte_array(m->stream, b_return, num);
 }
 
 int snapshot_module_read_word_array(snapshot_module_t *m, uint16_t *w_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
+    if ((long)(snapshot_stream_tell(m->stream) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_word_array(m->file, w_return, num);
+    return snapshot_read_word_array(m->stream, w_return, num);
 }
 
 int snapshot_module_read_dword_array(snapshot_module_t *m, uint32_t *dw_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
+    if ((long)(snapshot_stream_tell(m->stream) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_dword_array(m->file, dw_return, num);
+    return snapshot_read_dword_array(m->stream, dw_return, num);
 }
 
 int snapshot_module_read_string(snapshot_module_t *m, char **charp_return)
 {
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    if (snapshot_stream_tell(m->stream) + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_string(m->file, charp_return);
+    return snapshot_read_string(m->stream, charp_return);
 }
 
 int snapshot_module_read_byte_into_int(snapshot_module_t *m, int *value_return)
@@ -570,8 +711,8 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
     current_module = (char *)name;
 
     m = lib_malloc(sizeof(snapshot_module_t));
-    m->file = s->file;
-    m->offset = ftell(s->file);
+    m->stream = &s->stream;
+    m->offset = snapshot_stream_tell(&s->stream);
     if (m->offset == -1) {
         snapshot_error = SNAPSHOT_ILLEGAL_OFFSET_ERROR;
         lib_free(m);
@@ -579,15 +720,15 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
     }
     m->write_mode = 1;
 
-    if (snapshot_write_padded_string(s->file, name, (uint8_t)0, SNAPSHOT_MODULE_NAME_LEN) < 0
-        || snapshot_write_byte(s->file, major_version) < 0
-        || snapshot_write_byte(s->file, minor_version) < 0
-        || snapshot_write_dword(s->file, 0) < 0) {
+    if (snapshot_write_padded_string(&s->stream, name, (uint8_t)0, SNAPSHOT_MODULE_NAME_LEN) < 0
+        || snapshot_write_byte(&s->stream, major_version) < 0
+        || snapshot_write_byte(&s->stream, minor_version) < 0
+        || snapshot_write_dword(&s->stream, 0) < 0) {
         return NULL;
     }
 
-    m->size = ftell(s->file) - m->offset;
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size = snapshot_stream_tell(&s->stream) - m->offset;
+    m->size_offset = snapshot_stream_tell(&s->stream) - sizeof(uint32_t);
 
     return m;
 }
@@ -600,13 +741,13 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
 
     current_module = (char *)name;
 
-    if (fseek(s->file, s->first_module_offset, SEEK_SET) < 0) {
+    if (snapshot_stream_seek(&s->stream, s->first_module_offset) < 0) {
         snapshot_error = SNAPSHOT_FIRST_MODULE_NOT_FOUND_ERROR;
         return NULL;
     }
 
     m = lib_malloc(sizeof(snapshot_module_t));
-    m->file = s->file;
+    m->stream = &s->stream;
     m->write_mode = 0;
 
     m->offset = s->first_module_offset;
@@ -614,11 +755,11 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
     /* Search for the module name.  This is quite inefficient, but I don't
        think we care.  */
     while (1) {
-        if (snapshot_read_byte_array(s->file, (uint8_t *)n,
+        if (snapshot_read_byte_array(&s->stream, (uint8_t *)n,
                                      SNAPSHOT_MODULE_NAME_LEN) < 0
-            || snapshot_read_byte(s->file, major_version_return) < 0
-            || snapshot_read_byte(s->file, minor_version_return) < 0
-            || snapshot_read_dword(s->file, &m->size)) {
+            || snapshot_read_byte(&s->stream, major_version_return) < 0
+            || snapshot_read_byte(&s->stream, minor_version_return) < 0
+            || snapshot_read_dword(&s->stream, &m->size)) {
             snapshot_error = SNAPSHOT_MODULE_HEADER_READ_ERROR;
             goto fail;
         }
@@ -630,18 +771,18 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
         }
 
         m->offset += m->size;
-        if (fseek(s->file, m->offset, SEEK_SET) < 0) {
+        if (snapshot_stream_seek(&s->stream, m->offset) < 0) {
             snapshot_error = SNAPSHOT_MODULE_NOT_FOUND_ERROR;
             goto fail;
         }
     }
 
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size_offset = snapshot_stream_tell(&s->stream) - sizeof(uint32_t);
 
     return m;
 
 fail:
-    fseek(s->file, s->first_module_offset, SEEK_SET);
+    snapshot_stream_seek(&s->stream, s->first_module_offset);
     lib_free(m);
     return NULL;
 }
@@ -650,14 +791,14 @@ int snapshot_module_close(snapshot_module_t *m)
 {
     /* Backpatch module size if writing.  */
     if (m->write_mode
-        && (fseek(m->file, m->size_offset, SEEK_SET) < 0
-            || snapshot_write_dword(m->file, m->size) < 0)) {
+        && (snapshot_stream_seek(m->stream, m->size_offset) < 0
+            || snapshot_write_dword(m->stream, m->size) < 0)) {
         snapshot_error = SNAPSHOT_MODULE_CLOSE_ERROR;
         return -1;
     }
 
     /* Skip module.  */
-    if (fseek(m->file, m->offset + m->size, SEEK_SET) < 0) {
+    if (snapshot_stream_seek(m->stream, m->offset + m->size) < 0) {
         snapshot_error = SNAPSHOT_MODULE_SKIP_ERROR;
         return -1;
     }
@@ -668,43 +809,33 @@ int snapshot_module_close(snapshot_module_t *m)
 
 /* ------------------------------------------------------------------------- */
 
-snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
+static int snapshot_write_header(snapshot_stream_t *f, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
 {
-    FILE *f;
-    snapshot_t *s;
     unsigned char viceversion[4] = { VERSION_RC_NUMBER };
 
-    current_filename = (char *)filename;
-
-    f = fopen(filename, MODE_WRITE);
-    if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
-        return NULL;
-    }
-
     /* Magic string.  */
     if (snapshot_write_padded_string(f, snapshot_magic_string, (uint8_t)0, SNAPSHOT_MAGIC_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_WRITE_MAGIC_STRING_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Version number.  */
     if (snapshot_write_byte(f, major_version) < 0
         || snapshot_write_byte(f, minor_version) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_WRITE_VERSION_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Machine.  */
     if (snapshot_write_padded_string(f, snapshot_machine_name, (uint8_t)0, SNAPSHOT_MACHINE_NAME_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_WRITE_MACHINE_NAME_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* VICE version and revision */
     if (snapshot_write_padded_string(f, snapshot_version_magic_string, (uint8_t)0, SNAPSHOT_VERSION_MAGIC_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_WRITE_MAGIC_STRING_ERROR;
-        goto fail;
+        return -1;
     }
 
     if (snapshot_write_byte(f, viceversion[0]) < 0
@@ -717,62 +848,91 @@ snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t
         || snapshot_write_dword(f, 0) < 0) {
 #endif
         snapshot_error = SNAPSHOT_CANNOT_WRITE_VERSION_ERROR;
-        goto fail;
+        return -1;
+    }
+
+    return 0;
+}
+
+snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
+{
+    FILE *f;
+    snapshot_t *s;
+
+    current_filename = (char *)filename;
+
+    f = fopen(filename, MODE_WRITE);
+    if (f == NULL) {
+        snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
+        return NULL;
+    }
+
+    s = lib_calloc(1, sizeof(snapshot_t));
+    s->stream.file = f;
+
+    if (snapshot_write_header(&s->stream, major_version, minor_version, snapshot_machine_name) < 0) {
+        fclose(f);
+        ioutil_remove(filename);
+        lib_free(s);
+        return NULL;
     }
 
-    s = lib_malloc(sizeof(snapshot_t));
-    s->file = f;
     s->first_module_offset = ftell(f);
     s->write_mode = 1;
 
     return s;
+}
 
-fail:
-    fclose(f);
-    ioutil_remove(filename);
-    return NULL;
+/* Create a snapshot in a growable memory buffer.  The buffer is handed to
+   the caller by `snapshot_close_mem()'.  */
+snapshot_t *snapshot_create_mem(uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
+{
+    snapshot_t *s;
+
+    current_filename = snapshot_mem_name;
+
+    s = lib_calloc(1, sizeof(snapshot_t));
+
+    if (snapshot_write_header(&s->stream, major_version, minor_version, snapshot_machine_name) < 0) {
+        lib_free(s->stream.buffer);
+        lib_free(s);
+        return NULL;
+    }
+
+    s->first_module_offset = (long)s->stream.pos;
+    s->write_mode = 1;
+
+    return s;
 }
 
 /* informal only, used by the error message created below */
 static unsigned char snapshot_viceversion[4];
 static uint32_t snapshot_vicerevision;
 
-snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
+static int snapshot_read_header(snapshot_stream_t *f, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
 {
-    FILE *f;
     char magic[SNAPSHOT_MAGIC_LEN];
-    snapshot_t *s = NULL;
     int machine_name_len;
-    size_t offs;
-
-    current_machine_name = (char *)snapshot_machine_name;
-    current_filename = (char *)filename;
-    current_module = NULL;
-
-    f = zfile_fopen(filename, MODE_READ);
-    if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
-        return NULL;
-    }
+    long offs;
 
     /* Magic string.  */
     if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_MAGIC_LEN) < 0
         || memcmp(magic, snapshot_magic_string, SNAPSHOT_MAGIC_LEN) != 0) {
         snapshot_error = SNAPSHOT_MAGIC_STRING_MISMATCH_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Version number.  */
     if (snapshot_read_byte(f, major_version_return) < 0
         || snapshot_read_byte(f, minor_version_return) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_READ_VERSION_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Machine.  */
     if (snapshot_read_byte_array(f, (uint8_t *)read_name, SNAPSHOT_MACHINE_NAME_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_READ_MACHINE_NAME_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* Check machine name.  */
@@ -781,18 +941,18 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
         || (machine_name_len != SNAPSHOT_MODULE_NAME_LEN
             && read_name[machine_name_len] != 0)) {
         snapshot_error = SNAPSHOT_MACHINE_MISMATCH_ERROR;
-        goto fail;
+        return -1;
     }
 
     /* VICE version and revision */
     memset(snapshot_viceversion, 0, 4);
     snapshot_vicerevision = 0;
-    offs = ftell(f);
+    offs = snapshot_stream_tell(f);
 
     if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_VERSION_MAGIC_LEN) < 0
         || memcmp(magic, snapshot_version_magic_string, SNAPSHOT_VERSION_MAGIC_LEN) != 0) {
         /* old snapshots do not contain VICE version */
-        fseek(f, offs, SEEK_SET);
+        snapshot_stream_seek(f, offs);
         log_warning(LOG_DEFAULT, "attempting to load pre 2.4.30 snapshot");
     } else {
         /* actually read the version */
@@ -802,36 +962,90 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
             || snapshot_read_byte(f, &snapshot_viceversion[3]) < 0
             || snapshot_read_dword(f, &snapshot_vicerevision) < 0) {
             snapshot_error = SNAPSHOT_CANNOT_READ_VERSION_ERROR;
-            goto fail;
+            return -1;
         }
     }
 
-    s = lib_malloc(sizeof(snapshot_t));
-    s->file = f;
+    return 0;
+}
+
+snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
+{
+    FILE *f;
+    snapshot_t *s = NULL;
+
+    current_machine_name = (char *)snapshot_machine_name;
+    current_filename = (char *)filename;
+    current_module = NULL;
+
+    f = zfile_fopen(filename, MODE_READ);
+    if (f == NULL) {
+        snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
+        return NULL;
+    }
+
+    s = lib_calloc(1, sizeof(snapshot_t));
+    s->stream.file = f;
+
+    if (snapshot_read_header(&s->stream, major_version_return, minor_version_return, snapshot_machine_name) < 0) {
+        fclose(f);
+        lib_free(s);
+        return NULL;
+    }
+
     s->first_module_offset = ftell(f);
     s->write_mode = 0;
 
     vsync_suspend_speed_eval();
     return s;
+}
 
-fail:
-    fclose(f);
-    return NULL;
+/* Open a snapshot held in memory, e.g. one returned by
+   `snapshot_close_mem()'.  The data is not copied and must stay valid until
+   the snapshot is closed.  */
+snapshot_t *snapshot_open_mem(const uint8_t *data, size_t size, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
+{
+    snapshot_t *s;
+
+    current_machine_name = (char *)snapshot_machine_name;
+    current_filename = snapshot_mem_name;
+    current_module = NULL;
+
+    s = lib_calloc(1, sizeof(snapshot_t));
+    s->stream.buffer = (uint8_t *)data;
+    s->stream.size = size;
+    s->stream.alloc = size;
+    s->stream.foreign_buffer = 1;
+
+    if (snapshot_read_header(&s->stream, major_version_return, minor_version_return, snapshot_machine_name) < 0) {
+        lib_free(s);
+        return NULL;
+    }
+
+    s->first_module_offset = (long)s->stream.pos;
+    s->write_mode = 0;
+
+    return s;
 }
 
 int snapshot_close(snapshot_t *s)
 {
     int retval;
 
-    if (!s->write_mode) {
-        if (zfile_fclose(s->file) == EOF) {
+    if (s->stream.file == NULL) {
+        if (!s->stream.foreign_buffer) {
+            lib_free(s->stream.buffer);
+        }
+        retval = 0;
+    } else if (!s->write_mode) {
+        if (zfile_fclose(s->stream.file) == EOF) {
             snapshot_error = SNAPSHOT_READ_CLOSE_EOF_ERROR;
             retval = -1;
         } else {
             retval = 0;
         }
     } else {
-        if (fclose(s->file) == EOF) {
+        if (fclose(s->stream.file) == EOF) {
             snapshot_error = SNAPSHOT_WRITE_CLOSE_EOF_ERROR;
             retval = -1;
         } else {
@@ -843,6 +1057,18 @@ int snapshot_close(snapshot_t *s)
     return retval;
 }
 
+/* Close a snapshot created by `snapshot_create_mem()' and return its data,
+   which the caller must free with `lib_free()'.  */
+uint8_t *snapshot_close_mem(snapshot_t *s, size_t *size_return)
+{
+    uint8_t *data = s->stream.buffer;
+
+    *size_return = s->stream.size;
+
+    lib_free(s);
+    return data;
+}
+
 static void display_error_with_vice_version(char *text, char *filename)
 {
     char *vmessage = lib_malloc(0x100);
@@ -145,6 +145,15 @@ extern snapshot_t *snapshot_open(const char *filename,
                                  const char *snapshot_machine_name);
 extern int snapshot_close(snapshot_t *s);
 
+extern snapshot_t *snapshot_create_mem(uint8_t major_version,
+                                       uint8_t minor_version,
+                                       const char *snapshot_machine_name);
+extern snapshot_t *snapshot_open_mem(const uint8_t *data, size_t size,
+                                     uint8_t *major_version_return,
+                                     uint8_t *minor_version_return,
+                                     const char *snapshot_machine_name);
+extern uint8_t *snapshot_close_mem(snapshot_t *s, size_t *size_return);
+
 extern void snapshot_set_error(int error);
 
 extern int snapshot_version_at_least(uint8_t major_version, uint8_t minor_version, uint8_t major_version_required, uint8_t minor_version_required);
@@ -72,7 +72,7 @@ static void debugcart_store(uint16_t addr, uint8_t value)
 {
     int n = (int)value;
     fprintf(stdout, "DBGCART: exit(%d) cycles elapsed: %d\n", n, maincpu_clk);
-    exit(n);
+    exit(MACHINE_EXIT_DEBUGCART(n));
 }
 
 /* ------------------------------------------------------------------------- */
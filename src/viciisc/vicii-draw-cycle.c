@@ -482,7 +482,12 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     if (cycle_is_sprite_dma1_dma2(cycle_flags)) {
         dma_cycle_2 = 1 << cycle_get_sprite_num(cycle_flags);
     }
-    candidate_bits = get_trigger_candidates(xpos);
+    /* sprites can only be triggered while pending */
+    if (sprite_pending_bits || spr_en) {
+        candidate_bits = get_trigger_candidates(xpos);
+    } else {
+        candidate_bits = 0;
+    }
 
     /* process and render sprites */
     /* pixel 0 */
@@ -659,6 +664,34 @@ static DRAW_INLINE void draw_colors8(void)
     update_cregs();
 }
 
+/*
+ * Same as draw_colors8() but without writing to the draw buffer, used
+ * while the frame is skipped.  Only the color pipeline is advanced so
+ * that the first displayed line after a skipped frame comes out exactly
+ * the same.
+ */
+static DRAW_INLINE void skip_colors8(void)
+{
+    /* guard (could possibly be removed) */
+    if (vicii.dbuf_offset > VICII_DRAW_BUFFER_SIZE - 8) {
+        return;
+    }
+
+    /* update color register (if written) */
+    if (last_color_reg != 0xff) {
+        cregs[last_color_reg] = last_color_value;
+    }
+
+    /* this is what is left in the pixel buffer by draw_colors_*() */
+    memcpy(pixel_buffer, render_buffer, 8);
+    if (vicii.color_latency) {
+        pixel_buffer[0] = cregs[pixel_buffer[0]];
+    }
+    vicii.dbuf_offset += 8;
+
+    update_cregs();
+}
+
 
 /**************************************************************************
  *
@@ -679,7 +712,14 @@ void vicii_draw_cycle(void)
 
     draw_border8();
 
-    draw_colors8();
+    /* The draw buffer of a line is copied to the frame at cycle 1 of the
+       next line, after which the frame skip state may change.  Always
+       render cycle 1 so that line is complete if the frame is shown.  */
+    if (vicii.raster.skip_frame && vicii.raster_cycle != 1) {
+        skip_colors8();
+    } else {
+        draw_colors8();
+    }
 
     cycle_flags_pipe = vicii.cycle_flags;
 }
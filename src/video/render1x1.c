@@ -27,6 +27,7 @@
 #include "vice.h"
 
 #include "render1x1.h"
+#include "rendersimd.h"
 #include "types.h"
 
 
@@ -218,6 +219,11 @@ void render_32_1x1_04(const video_render_color_tables_t *color_tab, const uint8_
     const uint8_t *tmpsrc;
     uint32_t *tmptrg;
     unsigned int x, y, wstart, wfast, wend;
+#ifdef RENDER_SIMD
+    render_simd_palette_t palette;
+
+    render_simd_palette_init(&palette, colortab);
+#endif
 
     src = src + pitchs * ys + xs;
     trg = trg + pitcht * yt + (xt << 2);
@@ -234,6 +240,13 @@ void render_32_1x1_04(const video_render_color_tables_t *color_tab, const uint8_
     for (y = 0; y < height; y++) {
         tmpsrc = src;
         tmptrg = (uint32_t *)trg;
+#ifdef RENDER_SIMD
+        if (render_simd_32_1x(&palette, colortab, tmpsrc, tmptrg, width)) {
+            src += pitchs;
+            trg += pitcht;
+            continue;
+        }
+#endif
         for (x = 0; x < wstart; x++) {
             *tmptrg++ = colortab[*tmpsrc++];
         }
@@ -27,6 +27,7 @@
 #include "vice.h"
 
 #include "render2x2.h"
+#include "rendersimd.h"
 #include "types.h"
 #include <string.h>
 
@@ -301,6 +302,11 @@ void render_32_2x2_04(const video_render_color_tables_t *color_tab,
     unsigned int x, y, wfirst, wstart, wfast, wend, wlast, yys;
     register uint32_t color;
     int readable = config->readable;
+#ifdef RENDER_SIMD
+    render_simd_palette_t palette;
+
+    render_simd_palette_init(&palette, colortab);
+#endif
 
     src = src + pitchs * ys + xs;
     trg = trg + pitcht * yt + (xt << 2);
@@ -325,6 +331,15 @@ void render_32_2x2_04(const video_render_color_tables_t *color_tab,
         if (!(y & 1) || doublescan) {
             if ((y & 1) && readable && y > yys) { /* copy previous line */
                 memcpy(trg, trg - pitcht, ((width << 1) + wfirst + wlast) << 2);
+#ifdef RENDER_SIMD
+            } else if (render_simd_32_2x(&palette, colortab, tmpsrc + wfirst, tmptrg + wfirst, width)) {
+                if (wfirst) {
+                    *tmptrg = colortab[*tmpsrc];
+                }
+                if (wlast) {
+                    tmptrg[wfirst + (width << 1)] = colortab[tmpsrc[wfirst + width]];
+                }
+#endif
             } else {
                 if (wfirst) {
                     *tmptrg++ = colortab[*tmpsrc++];
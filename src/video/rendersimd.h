@@ -0,0 +1,189 @@
+/*
+ * rendersimd.h - Vectorized colour lookup for the 16 colour renderers
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_RENDERSIMD_H
+#define VICE_RENDERSIMD_H
+
+#include "types.h"
+
+/* With only 16 colours each byte of the physical colour is a 16 entry table,
+   which fits a byte shuffle.  16 pixels are looked up at once this way, one
+   shuffle per byte of the colour, and then interleaved into 32 bit pixels.
+   Rows with colour indices above 15 are left to the plain renderers.  The
+   instruction set is selected when compiling, e.g. with -mssse3 or -msimd128
+   for emscripten.  */
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define RENDER_SIMD
+
+typedef __m128i render_simd_vec_t;
+
+#define RENDER_SIMD_LOAD(p)             _mm_loadu_si128((const __m128i *)(p))
+#define RENDER_SIMD_STORE(p, v)         _mm_storeu_si128((__m128i *)(p), (v))
+#define RENDER_SIMD_LOOKUP(t, i)        _mm_shuffle_epi8((t), (i))
+#define RENDER_SIMD_HIGH_INDEX(i)       (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128((i), _mm_set1_epi8((char)0xf0)), _mm_setzero_si128())) != 0xffff)
+#define RENDER_SIMD_ZIPLO_8(a, b)       _mm_unpacklo_epi8((a), (b))
+#define RENDER_SIMD_ZIPHI_8(a, b)       _mm_unpackhi_epi8((a), (b))
+#define RENDER_SIMD_ZIPLO_16(a, b)      _mm_unpacklo_epi16((a), (b))
+#define RENDER_SIMD_ZIPHI_16(a, b)      _mm_unpackhi_epi16((a), (b))
+#define RENDER_SIMD_ZIPLO_32(a, b)      _mm_unpacklo_epi32((a), (b))
+#define RENDER_SIMD_ZIPHI_32(a, b)      _mm_unpackhi_epi32((a), (b))
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define RENDER_SIMD
+
+typedef uint8x16_t render_simd_vec_t;
+
+#define RENDER_SIMD_LOAD(p)             vld1q_u8((const uint8_t *)(p))
+#define RENDER_SIMD_STORE(p, v)         vst1q_u8((uint8_t *)(p), (v))
+#define RENDER_SIMD_LOOKUP(t, i)        vqtbl1q_u8((t), (i))
+#define RENDER_SIMD_HIGH_INDEX(i)       (vmaxvq_u8(i) > 15)
+#define RENDER_SIMD_ZIPLO_8(a, b)       vzip1q_u8((a), (b))
+#define RENDER_SIMD_ZIPHI_8(a, b)       vzip2q_u8((a), (b))
+#define RENDER_SIMD_ZIPLO_16(a, b)      vreinterpretq_u8_u16(vzip1q_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)))
+#define RENDER_SIMD_ZIPHI_16(a, b)      vreinterpretq_u8_u16(vzip2q_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)))
+#define RENDER_SIMD_ZIPLO_32(a, b)      vreinterpretq_u8_u32(vzip1q_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)))
+#define RENDER_SIMD_ZIPHI_32(a, b)      vreinterpretq_u8_u32(vzip2q_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)))
+
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define RENDER_SIMD
+
+typedef v128_t render_simd_vec_t;
+
+#define RENDER_SIMD_LOAD(p)             wasm_v128_load(p)
+#define RENDER_SIMD_STORE(p, v)         wasm_v128_store((p), (v))
+#define RENDER_SIMD_LOOKUP(t, i)        wasm_i8x16_swizzle((t), (i))
+#define RENDER_SIMD_HIGH_INDEX(i)       wasm_v128_any_true(wasm_u8x16_gt((i), wasm_u8x16_splat(15)))
+#define RENDER_SIMD_ZIPLO_8(a, b)       wasm_i8x16_shuffle((a), (b), 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23)
+#define RENDER_SIMD_ZIPHI_8(a, b)       wasm_i8x16_shuffle((a), (b), 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31)
+#define RENDER_SIMD_ZIPLO_16(a, b)      wasm_i16x8_shuffle((a), (b), 0, 8, 1, 9, 2, 10, 3, 11)
+#define RENDER_SIMD_ZIPHI_16(a, b)      wasm_i16x8_shuffle((a), (b), 4, 12, 5, 13, 6, 14, 7, 15)
+#define RENDER_SIMD_ZIPLO_32(a, b)      wasm_i32x4_shuffle((a), (b), 0, 4, 1, 5)
+#define RENDER_SIMD_ZIPHI_32(a, b)      wasm_i32x4_shuffle((a), (b), 2, 6, 3, 7)
+
+#endif
+
+#ifdef RENDER_SIMD
+
+/* The bytes of the first 16 physical colours, in memory order.  */
+typedef struct render_simd_palette_s {
+    render_simd_vec_t byte[4];
+} render_simd_palette_t;
+
+inline static void render_simd_palette_init(render_simd_palette_t *palette, const uint32_t *colortab)
+{
+    uint8_t planes[4][16];
+    unsigned int i, j;
+
+    for (i = 0; i < 16; i++) {
+        for (j = 0; j < 4; j++) {
+            planes[j][i] = ((const uint8_t *)&colortab[i])[j];
+        }
+    }
+    for (j = 0; j < 4; j++) {
+        palette->byte[j] = RENDER_SIMD_LOAD(planes[j]);
+    }
+}
+
+/* Look up 16 pixels, returning them 4 at a time in `p'.  */
+inline static int render_simd_lookup16(const render_simd_palette_t *palette, const uint8_t *src,
+                                       render_simd_vec_t *p)
+{
+    render_simd_vec_t idx, b0, b1, b2, b3, lo01, hi01, lo23, hi23;
+
+    idx = RENDER_SIMD_LOAD(src);
+    if (RENDER_SIMD_HIGH_INDEX(idx)) {
+        return 0;
+    }
+    b0 = RENDER_SIMD_LOOKUP(palette->byte[0], idx);
+    b1 = RENDER_SIMD_LOOKUP(palette->byte[1], idx);
+    b2 = RENDER_SIMD_LOOKUP(palette->byte[2], idx);
+    b3 = RENDER_SIMD_LOOKUP(palette->byte[3], idx);
+    lo01 = RENDER_SIMD_ZIPLO_8(b0, b1);
+    hi01 = RENDER_SIMD_ZIPHI_8(b0, b1);
+    lo23 = RENDER_SIMD_ZIPLO_8(b2, b3);
+    hi23 = RENDER_SIMD_ZIPHI_8(b2, b3);
+    p[0] = RENDER_SIMD_ZIPLO_16(lo01, lo23);
+    p[1] = RENDER_SIMD_ZIPHI_16(lo01, lo23);
+    p[2] = RENDER_SIMD_ZIPLO_16(hi01, hi23);
+    p[3] = RENDER_SIMD_ZIPHI_16(hi01, hi23);
+    return 1;
+}
+
+/* Render `width' pixels of a row.  Returns 0 if the row has to be done by
+   the plain renderer, with some of `trg' possibly already written.  */
+inline static int render_simd_32_1x(const render_simd_palette_t *palette, const uint32_t *colortab,
+                                    const uint8_t *src, uint32_t *trg, unsigned int width)
+{
+    render_simd_vec_t p[4];
+
+    for (; width >= 16; width -= 16) {
+        if (!render_simd_lookup16(palette, src, p)) {
+            return 0;
+        }
+        RENDER_SIMD_STORE(trg, p[0]);
+        RENDER_SIMD_STORE(trg + 4, p[1]);
+        RENDER_SIMD_STORE(trg + 8, p[2]);
+        RENDER_SIMD_STORE(trg + 12, p[3]);
+        src += 16;
+        trg += 16;
+    }
+    while (width--) {
+        *trg++ = colortab[*src++];
+    }
+    return 1;
+}
+
+/* Like `render_simd_32_1x()', but with every pixel written twice.  */
+inline static int render_simd_32_2x(const render_simd_palette_t *palette, const uint32_t *colortab,
+                                    const uint8_t *src, uint32_t *trg, unsigned int width)
+{
+    render_simd_vec_t p[4];
+    uint32_t color;
+    unsigned int i;
+
+    for (; width >= 16; width -= 16) {
+        if (!render_simd_lookup16(palette, src, p)) {
+            return 0;
+        }
+        for (i = 0; i < 4; i++) {
+            RENDER_SIMD_STORE(trg, RENDER_SIMD_ZIPLO_32(p[i], p[i]));
+            RENDER_SIMD_STORE(trg + 4, RENDER_SIMD_ZIPHI_32(p[i], p[i]));
+            trg += 8;
+        }
+        src += 16;
+    }
+    while (width--) {
+        color = colortab[*src++];
+        *trg++ = color;
+        *trg++ = color;
+    }
+    return 1;
+}
+
+#endif
+
+#endif
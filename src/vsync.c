@@ -67,6 +67,7 @@ int vsync_frame_counter;
 #endif
 #include "network.h"
 #include "resources.h"
+#include "rewind.h"
 #include "sound.h"
 #include "translate.h"
 #include "types.h"
@@ -410,6 +411,8 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
 
     vsync_hook();
 
+    rewind_vsync();
+
     if (network_connected()) {
         network_hook_time = vsyncarch_gettime() - network_hook_time;
 
@@ -44,6 +44,9 @@
 #ifdef HAVE_ZLIB
 #include <zlib.h>
 #endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
 
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
@@ -53,6 +56,7 @@
 #include "ioutil.h"
 #include "lib.h"
 #include "log.h"
+#include "types.h"
 #include "util.h"
 #include "zfile.h"
 #include "zipcode.h"
@@ -68,6 +72,18 @@
 #define ZDEBUG(a)
 #endif
 
+/* gzip and zip files opened for reading are uncompressed in memory and
+   accessed through a memory stream instead of a temporary file.  */
+#if defined(HAVE_ZLIB) && defined(HAVE_FMEMOPEN) && defined(HAVE_SYS_STAT_H)
+#define ZFILE_IN_MEMORY
+#endif
+
+/* Number of uncompressed files kept around for opening them again.  */
+#define ZFILE_CACHE_SIZE 8
+
+/* Larger files are not uncompressed in memory.  */
+#define ZFILE_IN_MEMORY_MAX (64 * 1024 * 1024)
+
 /* We could add more here...  */
 enum compression_type {
     COMPR_NONE,
@@ -91,6 +107,7 @@ struct zfile_s {
     struct zfile_s *prev, *next; /* Link to the previous and next nodes.  */
     zfile_action_t action;       /* action on close */
     char *request_string;        /* ui string for action=ZFILE_REQUEST */
+    uint8_t *mem;                /* Buffer of a memory stream.  */
 };
 typedef struct zfile_s zfile_t;
 
@@ -175,6 +192,7 @@ static void zfile_list_add(const char *tmp_name,
     new_zfile->type = type;
     new_zfile->action = ZFILE_KEEP;
     new_zfile->request_string = NULL;
+    new_zfile->mem = NULL;
     new_zfile->next = zfile_list;
     new_zfile->prev = NULL;
     if (zfile_list != NULL) {
@@ -183,9 +201,12 @@ static void zfile_list_add(const char *tmp_name,
     zfile_list = new_zfile;
 }
 
+static void zfile_cache_destroy(void);
+
 void zfile_shutdown(void)
 {
     zfile_list_destroy();
+    zfile_cache_destroy();
 }
 
 /* ------------------------------------------------------------------------ */
@@ -814,6 +835,400 @@ static enum compression_type try_uncompress(const char *name,
 
 /* ------------------------------------------------------------------------- */
 
+/* Uncompression into memory.  */
+
+#ifdef ZFILE_IN_MEMORY
+
+/* Cache of uncompressed files, most recently used first.  An entry is only
+   used if the compressed file still has the same size and time stamp.  */
+typedef struct zfile_cache_s {
+    char *name;                  /* Complete path of the compressed file.  */
+    off_t size;                  /* Size of the compressed file.  */
+    time_t mtime;                /* Time stamp of the compressed file.  */
+    enum compression_type type;  /* Compression algorithm.  */
+    uint8_t *data;               /* Uncompressed data.  */
+    size_t len;                  /* Length of the uncompressed data.  */
+} zfile_cache_t;
+
+static zfile_cache_t zfile_cache[ZFILE_CACHE_SIZE];
+
+static void zfile_cache_entry_free(zfile_cache_t *entry)
+{
+    if (entry->name) {
+        lib_free(entry->name);
+    }
+    if (entry->data) {
+        lib_free(entry->data);
+    }
+    memset(entry, 0, sizeof(zfile_cache_t));
+}
+
+static void zfile_cache_destroy(void)
+{
+    int i;
+
+    for (i = 0; i < ZFILE_CACHE_SIZE; i++) {
+        zfile_cache_entry_free(&zfile_cache[i]);
+    }
+}
+
+/* Find `name' in the cache and move it to the front.  */
+static zfile_cache_t *zfile_cache_find(const char *name, const struct stat *st)
+{
+    zfile_cache_t entry;
+    int i;
+
+    for (i = 0; i < ZFILE_CACHE_SIZE && zfile_cache[i].name != NULL; i++) {
+        if (strcmp(zfile_cache[i].name, name) != 0) {
+            continue;
+        }
+        if (zfile_cache[i].size != st->st_size
+            || zfile_cache[i].mtime != st->st_mtime) {
+            /* outdated, drop it */
+            zfile_cache_entry_free(&zfile_cache[i]);
+            memmove(&zfile_cache[i], &zfile_cache[i + 1],
+                    (ZFILE_CACHE_SIZE - 1 - i) * sizeof(zfile_cache_t));
+            memset(&zfile_cache[ZFILE_CACHE_SIZE - 1], 0, sizeof(zfile_cache_t));
+            return NULL;
+        }
+        entry = zfile_cache[i];
+        memmove(&zfile_cache[1], &zfile_cache[0], i * sizeof(zfile_cache_t));
+        zfile_cache[0] = entry;
+        return &zfile_cache[0];
+    }
+    return NULL;
+}
+
+/* Add an entry to the front of the cache, taking over `name' and `data'.  */
+static zfile_cache_t *zfile_cache_add(char *name, const struct stat *st,
+                                      enum compression_type type,
+                                      uint8_t *data, size_t len)
+{
+    zfile_cache_entry_free(&zfile_cache[ZFILE_CACHE_SIZE - 1]);
+    memmove(&zfile_cache[1], &zfile_cache[0],
+            (ZFILE_CACHE_SIZE - 1) * sizeof(zfile_cache_t));
+    zfile_cache[0].name = name;
+    zfile_cache[0].size = st->st_size;
+    zfile_cache[0].mtime = st->st_mtime;
+    zfile_cache[0].type = type;
+    zfile_cache[0].data = data;
+    zfile_cache[0].len = len;
+    return &zfile_cache[0];
+}
+
+/* Uncompress a gzip file into memory.  */
+static uint8_t *uncompress_gzip_to_memory(const char *name, size_t *len)
+{
+    gzFile fdsrc;
+    uint8_t *data;
+    size_t size = 0x10000;
+    int n;
+
+    fdsrc = gzopen(name, MODE_READ);
+    if (fdsrc == NULL) {
+        return NULL;
+    }
+
+    data = lib_malloc(size);
+    *len = 0;
+    do {
+        if (*len == size) {
+            if (size >= ZFILE_IN_MEMORY_MAX) {
+                n = -1;
+                break;
+            }
+            size *= 2;
+            data = lib_realloc(data, size);
+        }
+        n = gzread(fdsrc, (void *)(data + *len), (unsigned int)(size - *len));
+        if (n > 0) {
+            *len += (size_t)n;
+        }
+    } while (n > 0);
+
+    gzclose(fdsrc);
+
+    if (n < 0) {
+        lib_free(data);
+        return NULL;
+    }
+    return data;
+}
+
+#define ZIP_LE16(p) ((unsigned int)(p)[0] | ((unsigned int)(p)[1] << 8))
+#define ZIP_LE32(p) (ZIP_LE16(p) | ((uint32_t)ZIP_LE16((p) + 2) << 16))
+
+/* Find the central directory entry of the zip file in `zip' whose name
+   matches `name', or the first one with an extension we know about if
+   `name' is NULL.  Copy the name of the entry into `found'.  */
+static const uint8_t *zip_find_entry(const uint8_t *zip, size_t zip_len,
+                                     const char *name, char *found)
+{
+    const uint8_t *p, *end;
+    size_t i, entries, cd_offset, name_len;
+
+    if (zip_len < 22) {
+        return NULL;
+    }
+
+    /* Search the end of central directory record, it may be followed by a
+       comment of up to 64k.  */
+    for (i = zip_len - 22; ; i--) {
+        if (ZIP_LE32(zip + i) == 0x06054b50) {
+            break;
+        }
+        if (i == 0 || zip_len - i > 22 + 0xffff) {
+            return NULL;
+        }
+    }
+    entries = ZIP_LE16(zip + i + 10);
+    cd_offset = ZIP_LE32(zip + i + 16);
+    if (cd_offset >= zip_len) {
+        return NULL;
+    }
+
+    p = zip + cd_offset;
+    end = zip + zip_len;
+    while (entries-- > 0) {
+        if (p + 46 > end || ZIP_LE32(p) != 0x02014b50) {
+            return NULL;
+        }
+        name_len = ZIP_LE16(p + 28);
+        if (p + 46 + name_len > end) {
+            return NULL;
+        }
+        if (name_len < 1024) {
+            memcpy(found, p + 46, name_len);
+            found[name_len] = 0;
+            if (name ? strcmp(found, name) == 0
+                     : is_valid_extension(found, name_len, 0) != 0) {
+                return p;
+            }
+        }
+        p += 46 + name_len + ZIP_LE16(p + 30) + ZIP_LE16(p + 32);
+    }
+    return NULL;
+}
+
+/* Uncompress the file described by the central directory entry `cd' and
+   append it to `data'.  */
+static int zip_extract_entry(const uint8_t *zip, size_t zip_len, const uint8_t *cd,
+                             uint8_t **data, size_t *len)
+{
+    const uint8_t *lh, *src;
+    unsigned int method = ZIP_LE16(cd + 10);
+    size_t comp_size = ZIP_LE32(cd + 20);
+    size_t size = ZIP_LE32(cd + 24);
+    size_t offset = ZIP_LE32(cd + 42);
+    z_stream z;
+    int ret;
+
+    /* no encryption, stored or deflated only */
+    if ((ZIP_LE16(cd + 8) & 1) || (method != 0 && method != 8)
+        || size > ZFILE_IN_MEMORY_MAX - *len || offset + 30 > zip_len) {
+        return -1;
+    }
+
+    lh = zip + offset;
+    if (ZIP_LE32(lh) != 0x04034b50) {
+        return -1;
+    }
+    src = lh + 30 + ZIP_LE16(lh + 26) + ZIP_LE16(lh + 28);
+    if (src > zip + zip_len || comp_size > (size_t)(zip + zip_len - src)) {
+        return -1;
+    }
+
+    *data = lib_realloc(*data, *len + size + 1);
+
+    if (method == 0) {
+        if (comp_size != size) {
+            return -1;
+        }
+        memcpy(*data + *len, src, size);
+        *len += size;
+        return 0;
+    }
+
+    memset(&z, 0, sizeof(z));
+    if (inflateInit2(&z, -MAX_WBITS) != Z_OK) {
+        return -1;
+    }
+    z.next_in = (Bytef *)src;
+    z.avail_in = (uInt)comp_size;
+    z.next_out = *data + *len;
+    z.avail_out = (uInt)size;
+    ret = inflate(&z, Z_FINISH);
+    inflateEnd(&z);
+
+    if (ret != Z_STREAM_END || z.total_out != size) {
+        return -1;
+    }
+    *len += size;
+    return 0;
+}
+
+/* Uncompress the first file with an extension we know about from a zip file
+   into memory, like `try_uncompress_archive()' does using unzip.  All four
+   parts of a zipcode file are put together.  */
+static uint8_t *uncompress_zip_to_memory(const char *name, size_t *len)
+{
+    FILE *fd;
+    uint8_t *zip, *data = NULL;
+    const uint8_t *cd;
+    size_t zip_len;
+    char found[1024], wanted[1024];
+    int i;
+
+    fd = fopen(name, MODE_READ);
+    if (fd == NULL) {
+        return NULL;
+    }
+    zip_len = util_file_length(fd);
+    if (zip_len == 0 || zip_len > ZFILE_IN_MEMORY_MAX) {
+        fclose(fd);
+        return NULL;
+    }
+    zip = lib_malloc(zip_len);
+    if (fread(zip, zip_len, 1, fd) < 1) {
+        fclose(fd);
+        lib_free(zip);
+        return NULL;
+    }
+    fclose(fd);
+
+    *len = 0;
+    cd = zip_find_entry(zip, zip_len, NULL, found);
+    if (cd != NULL && is_zipcode_name(found)) {
+        /* zip_find_entry() overwrites `found' with every name it looks at */
+        strcpy(wanted, found);
+        for (i = 0; i < 4 && cd != NULL; i++) {
+            wanted[0] = '1' + i;
+            cd = zip_find_entry(zip, zip_len, wanted, found);
+            if (cd != NULL && zip_extract_entry(zip, zip_len, cd, &data, len) < 0) {
+                cd = NULL;
+            }
+        }
+    } else if (cd != NULL && zip_extract_entry(zip, zip_len, cd, &data, len) < 0) {
+        cd = NULL;
+    }
+    lib_free(zip);
+
+    if (cd == NULL) {
+        if (data != NULL) {
+            lib_free(data);
+        }
+        return NULL;
+    }
+    ZDEBUG(("uncompress_zip_to_memory: extracted `%s'.", found));
+    return data;
+}
+
+/* Try to open `name' by uncompressing it in memory, or getting it from the
+   cache.  Files opened for reading get a memory stream, gzip files opened
+   for writing still need a temporary file to compress it again on close.
+   Return 0 if `name' cannot be handled this way, and 1 if it was, with the
+   stream or NULL in `stream'.  */
+static int zfile_fopen_memory(const char *name, const char *mode,
+                              int write_mode, FILE **stream)
+{
+    char *full_name = NULL;
+    char *tmp_name = NULL;
+    struct stat st;
+    zfile_cache_t *entry;
+    enum compression_type type;
+    uint8_t *data;
+    size_t l = strlen(name);
+    size_t len = 0;
+    FILE *fd;
+
+    *stream = NULL;
+
+    if (l > 4 && strcasecmp(name + l - 4, ".zip") == 0) {
+        type = COMPR_ARCHIVE;
+    } else if (file_is_gzip(name)
+               && !(l > 7 && strcasecmp(name + l - 7, ".tar.gz") == 0)) {
+        type = COMPR_GZIP;
+    } else {
+        return 0;
+    }
+
+    if (stat(name, &st) < 0) {
+        return 0;
+    }
+
+    archdep_expand_path(&full_name, name);
+    entry = zfile_cache_find(full_name, &st);
+    if (entry == NULL) {
+        if (type == COMPR_GZIP) {
+            data = uncompress_gzip_to_memory(name, &len);
+        } else {
+            data = uncompress_zip_to_memory(name, &len);
+        }
+        if (data != NULL && len == 0) {
+            lib_free(data);
+            data = NULL;
+        }
+        if (data == NULL) {
+            /* leave it to the external programs */
+            lib_free(full_name);
+            return 0;
+        }
+        entry = zfile_cache_add(full_name, &st, type, data, len);
+    } else {
+        lib_free(full_name);
+    }
+
+    if (write_mode) {
+        if (entry->type != COMPR_GZIP) {
+            /* cannot handle archives in write mode */
+            errno = EACCES;
+            return 1;
+        }
+        fd = archdep_mkstemp_fd(&tmp_name, MODE_WRITE);
+        if (fd == NULL) {
+            return 1;
+        }
+        if (entry->len > 0 && fwrite(entry->data, entry->len, 1, fd) < 1) {
+            fclose(fd);
+            ioutil_remove(tmp_name);
+            lib_free(tmp_name);
+            return 1;
+        }
+        fclose(fd);
+        *stream = fopen(tmp_name, mode);
+        if (*stream == NULL) {
+            ioutil_remove(tmp_name);
+        } else {
+            zfile_list_add(tmp_name, name, COMPR_GZIP, write_mode, *stream, NULL);
+        }
+        lib_free(tmp_name);
+        return 1;
+    }
+
+    /* The stream gets its own copy, the cache entry may be dropped while
+       the file is still open.  */
+    data = lib_malloc(entry->len + 1);
+    memcpy(data, entry->data, entry->len);
+    *stream = fmemopen(data, entry->len, mode);
+    if (*stream == NULL) {
+        lib_free(data);
+        return 1;
+    }
+    zfile_list_add(NULL, name, entry->type, 0, *stream, NULL);
+    zfile_list->mem = data;
+    return 1;
+}
+
+#else
+
+static void zfile_cache_destroy(void)
+{
+}
+
+#endif /* ZFILE_IN_MEMORY */
+
+/* ------------------------------------------------------------------------- */
+
 /* Compression.  */
 
 /* Compress `src' into `dest' using gzip.  */
@@ -1047,6 +1462,12 @@ FILE *zfile_fopen(const char *name, const char *mode)
         return NULL;
     }
 
+#ifdef ZFILE_IN_MEMORY
+    if (zfile_fopen_memory(name, mode, write_mode, &stream)) {
+        return stream;
+    }
+#endif
+
     type = try_uncompress(name, &tmp_name, write_mode);
     if (type == COMPR_NONE) {
         stream = fopen(name, mode);
@@ -1142,6 +1563,9 @@ static int handle_close(zfile_t *ptr)
     if (ptr->request_string) {
         lib_free(ptr->request_string);
     }
+    if (ptr->mem) {
+        lib_free(ptr->mem);
+    }
 
     lib_free(ptr);
 